@@ -8,6 +8,8 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
 #include "IKRigUtils.hpp"
+#include "SoulFTransformBatch.h"
+#include "SoulRetargetPlanCache.h"
 
 using namespace SoulIK;
 
@@ -32,10 +34,10 @@ std::shared_ptr<UIKRetargeter> IKRigUtils::createIKRigAsset(SoulIKRigRetargetCon
     InRetargeterAsset.SourceIKRigAsset->RetargetDefinition.RootType = config.SourceRootType;
 
     // chain
-    InRetargeterAsset.SourceIKRigAsset->RetargetDefinition.BoneChains.resize(config.SourceChains.size());
+    TArray<FBoneChain> sourceChains(config.SourceChains.size());
     for(size_t i = 0; i < config.SourceChains.size(); i++) {
         auto& chain = config.SourceChains[i];
-        auto& BoneChain = InRetargeterAsset.SourceIKRigAsset->RetargetDefinition.BoneChains[i];
+        auto& BoneChain = sourceChains[i];
 
         BoneChain.ChainName = chain.chainName;
         BoneChain.StartBone.BoneName = chain.startBone;
@@ -43,6 +45,7 @@ std::shared_ptr<UIKRetargeter> IKRigUtils::createIKRigAsset(SoulIKRigRetargetCon
         BoneChain.EndBone.BoneName = chain.endBone;
         BoneChain.EndBone.BoneIndex = srcsk.getJointIdByName(chain.endBone);
     }
+    InRetargeterAsset.SourceIKRigAsset->RetargetDefinition.SetBoneChains(std::move(sourceChains));
 
     ///////////////////////////////////////
     // ikrig 2
@@ -59,10 +62,10 @@ std::shared_ptr<UIKRetargeter> IKRigUtils::createIKRigAsset(SoulIKRigRetargetCon
     InRetargeterAsset.TargetIKRigAsset->RetargetDefinition.RootType = config.TargetRootType;
 
     // chain
-    InRetargeterAsset.TargetIKRigAsset->RetargetDefinition.BoneChains.resize(config.TargetChains.size());
+    TArray<FBoneChain> targetChains(config.TargetChains.size());
     for(size_t i = 0; i < config.TargetChains.size(); i++) {
         auto& chain = config.TargetChains[i];
-        auto& BoneChain = InRetargeterAsset.TargetIKRigAsset->RetargetDefinition.BoneChains[i];
+        auto& BoneChain = targetChains[i];
 
         BoneChain.ChainName = chain.chainName;
         BoneChain.StartBone.BoneName = chain.startBone;
@@ -70,6 +73,7 @@ std::shared_ptr<UIKRetargeter> IKRigUtils::createIKRigAsset(SoulIKRigRetargetCon
         BoneChain.EndBone.BoneName = chain.endBone;
         BoneChain.EndBone.BoneIndex = tgtsk.getJointIdByName(chain.endBone);
     }
+    InRetargeterAsset.TargetIKRigAsset->RetargetDefinition.SetBoneChains(std::move(targetChains));
 
     ///////////////////////////////////////
     // mapping
@@ -91,6 +95,46 @@ std::shared_ptr<UIKRetargeter> IKRigUtils::createIKRigAsset(SoulIKRigRetargetCon
     return pInRetargeterAsset;
 }
 
+uint64_t IKRigUtils::hashRetargetInputs(SoulIKRigRetargetConfig const& config, USkeleton const& srcusk, USkeleton const& tgtusk) {
+    FContentHash hash;
+    hash.Add(srcusk);
+    hash.Add(tgtusk);
+
+    // what createIKRigAsset reads from the config, coords are already applied to the uskeletons
+    hash.Add(config.SourceRootType);
+    hash.Add(config.SourceRootBone);
+    hash.Add(config.SourceGroundBone);
+    hash.Add(config.TargetRootType);
+    hash.Add(config.TargetRootBone);
+    hash.Add(config.TargetGroundBone);
+    for (auto* chains : {&config.SourceChains, &config.TargetChains}) {
+        hash.Add((uint64_t)chains->size());
+        for (auto& chain : *chains) {
+            hash.Add(chain.chainName);
+            hash.Add(chain.startBone);
+            hash.Add(chain.endBone);
+        }
+    }
+    hash.Add((uint64_t)config.ChainMapping.size());
+    for (auto& mapping : config.ChainMapping) {
+        hash.Add(mapping.EnableFK);
+        hash.Add(mapping.EnableIK);
+        hash.Add(mapping.SourceChain);
+        hash.Add(mapping.TargetChain);
+    }
+    return hash.Get();
+}
+
+std::shared_ptr<const FRetargetPlan> IKRigUtils::getRetargetPlan(SoulIKRigRetargetConfig& config,
+    SoulSkeleton& srcsk, SoulSkeleton& tgtsk, USkeleton& srcusk, USkeleton& tgtusk, FIKRigLogger& log) {
+
+    uint64_t key = hashRetargetInputs(config, srcusk, tgtusk);
+    return FRetargetPlanCache::Get().FindOrCreate(key, srcusk, tgtusk,
+        [&](USkeleton& cachedsrcusk, USkeleton& cachedtgtusk) {
+            return createIKRigAsset(config, srcsk, tgtsk, cachedsrcusk, cachedtgtusk);
+        }, log);
+}
+
 std::string SoulIKRigRetargetConfig::to_string() {
     std::vector<char> s(1024 * 1024);
     int buflen = 1024 * 1024;
@@ -181,56 +225,51 @@ std::string IKRigUtils::ERootTypeToString(ERootType aRootType) {
     return "unkown ERootType";	             
 }
 
-FTransform IKRigUtils::getFTransformFromCoord(CoordType srcCoord, CoordType tgtCoord) {
-    FTransform t = FTransform::Identity;
+namespace {
+    // number of CoordType values, keep in sync with the enum
+    constexpr int CoordTypeCount = 2;
 
-    // same
-    if (srcCoord == tgtCoord) {
-        return t;
-    }
+    // constant coord convert transforms, [src][tgt], built once
+    struct FCoordTransformTable {
+        FTransform Table[CoordTypeCount][CoordTypeCount];
 
-    // diff
-    if (srcCoord == CoordType::RightHandYupZfront && tgtCoord == CoordType::RightHandZupYfront) {
-        // maya to 3dsmax  (x,y,z)->(-x,z,y)
-        // x 90 then z 180
-        double coshalf1 = std::cos(M_PI_4);
-        double sinhalf1 = std::sin(M_PI_4);
-        double coshalf2 = 0.0;
-        double sinhalf2 = 1.0;
-        FQuat q1 = FQuat(sinhalf1, 0.0, 0.0, coshalf1);
-        FQuat q2 = FQuat(0.0, 0.0, sinhalf2, coshalf2);
-        FQuat q = q2 * q1;
-        q.Normalize();
-        t = FTransform(q);
-    } else if (srcCoord == CoordType::RightHandZupYfront && tgtCoord == CoordType::RightHandYupZfront) {
-        // 3dsmax to maya   (x,y,z)->(-x,z,y)
-        // z -180 then x -90
+        FCoordTransformTable() {
+            for (int src = 0; src < CoordTypeCount; src++) {
+                for (int tgt = 0; tgt < CoordTypeCount; tgt++) {
+                    Table[src][tgt] = FTransform::Identity;
+                }
+            }
 
-        // double coshalf1 = 0.0;
-        // double sinhalf1 = 1.0;
-        // double coshalf2 = std::cos(-M_PI_4);
-        // double sinhalf2 = std::sin(-M_PI_4);
-        // FQuat q1 = FQuat(sinhalf1, 0.0, 0.0, coshalf1);
-        // FQuat q2 = FQuat(0.0, 0.0, sinhalf2, coshalf2);
-        // FQuat q = q2 * q1;
-        // q.Normalize();
-        // t = FTransform(q);
+            // maya to 3dsmax  (x,y,z)->(-x,z,y)
+            // x 90 then z 180
+            double coshalf1 = std::cos(M_PI_4);
+            double sinhalf1 = std::sin(M_PI_4);
+            double coshalf2 = 0.0;
+            double sinhalf2 = 1.0;
+            FQuat q1 = FQuat(sinhalf1, 0.0, 0.0, coshalf1);
+            FQuat q2 = FQuat(0.0, 0.0, sinhalf2, coshalf2);
+            FQuat q = q2 * q1;
+            q.Normalize();
+            Table[int(CoordType::RightHandYupZfront)][int(CoordType::RightHandZupYfront)] = FTransform(q);
+
+            // 3dsmax to maya   (x,y,z)->(-x,z,y)
+            // z -180 then x -90
+            FQuat qinv = q.Inverse();
+            qinv.Normalize();
+            Table[int(CoordType::RightHandZupYfront)][int(CoordType::RightHandYupZfront)] = FTransform(qinv);
+        }
+    };
+}
 
-        double coshalf1 = std::cos(M_PI_4);
-        double sinhalf1 = std::sin(M_PI_4);
-        double coshalf2 = 0.0;
-        double sinhalf2 = 1.0;
-        FQuat q1 = FQuat(sinhalf1, 0.0, 0.0, coshalf1);
-        FQuat q2 = FQuat(0.0, 0.0, sinhalf2, coshalf2);
-        FQuat q = q2 * q1;
-        q = q.Inverse();
-        q.Normalize();
-        t = FTransform(q);
-    } else {
+const FTransform& IKRigUtils::getFTransformFromCoord(CoordType srcCoord, CoordType tgtCoord) {
+    static const FCoordTransformTable CoordTransforms;
+
+    if (int(srcCoord) >= CoordTypeCount || int(tgtCoord) >= CoordTypeCount) {
         printf("not support\n");
         assert(false);
+        return FTransform::Identity;
     }
-    return t;
+    return CoordTransforms.Table[int(srcCoord)][int(tgtCoord)];
 }
 
 bool IKRigUtils::LocalFPoseCoordConvert(CoordType srcCoord, CoordType tgtCoord, std::vector<FTransform>& pose) {  
@@ -240,7 +279,7 @@ bool IKRigUtils::LocalFPoseCoordConvert(CoordType srcCoord, CoordType tgtCoord,
     }
 
     // generate transform
-    FTransform t = getFTransformFromCoord(srcCoord, tgtCoord);
+    const FTransform& t = getFTransformFromCoord(srcCoord, tgtCoord);
 
     // transform root
     pose[0] = pose[0] * t;
@@ -254,7 +293,7 @@ bool IKRigUtils::GlobalFPoseCoordConvert(CoordType srcCoord, CoordType tgtCoord,
     }
     
     // generate transform
-    FTransform t = getFTransformFromCoord(srcCoord, tgtCoord);
+    const FTransform& t = getFTransformFromCoord(srcCoord, tgtCoord);
 
     // transform all
     for(auto& posei : pose) {
@@ -270,7 +309,7 @@ void IKRigUtils::USkeletonCoordConvert(CoordType srcCoord, CoordType tgtCoord, U
     }
 
     // generate transform
-    FTransform t = getFTransformFromCoord(srcCoord, tgtCoord);
+    const FTransform& t = getFTransformFromCoord(srcCoord, tgtCoord);
 
     // transform
     sk.refpose[0] = sk.refpose[0] * t;
@@ -417,6 +456,8 @@ bool IKRigUtils::GlobalSoulPoseCoordConvert(CoordType srcCoord, CoordType tgtCoo
     return true;
 }
 
+// pose local/global conversions are one forward pass over the joints,
+// the fbx loaders keep SoulSkeleton joints parent before child (asserted per joint)
 void IKRigUtils::FPoseToLocal(SoulSkeleton& sk, std::vector<FTransform>& globalpose, std::vector<FTransform>& localpose) {
     assert(sk.joints.size() == globalpose.size());
     localpose.resize(globalpose.size());
@@ -424,7 +465,8 @@ void IKRigUtils::FPoseToLocal(SoulSkeleton& sk, std::vector<FTransform>& globalp
     localpose[0] = globalpose[0];
     for(int jointId = 1; jointId < globalpose.size(); jointId++) {
         int parentId = sk.joints[jointId].parentId;
-        localpose[jointId] = globalpose[jointId].GetRelativeTransform(globalpose[parentId]);
+        assert(parentId < jointId);
+        TransformKernel::Relative(localpose[jointId], globalpose[jointId], globalpose[parentId]);
     }
 }
 
@@ -435,7 +477,83 @@ void IKRigUtils::FPoseToGlobal(SoulSkeleton& sk, std::vector<FTransform>& localp
     globalpose[0] = localpose[0];
     for(int jointId = 1; jointId < localpose.size(); jointId++) {
         int parentId = sk.joints[jointId].parentId;
-        globalpose[jointId] = localpose[jointId] * globalpose[parentId];
+        assert(parentId < jointId);
+        TransformKernel::Multiply(globalpose[jointId], localpose[jointId], globalpose[parentId]);
+    }
+}
+
+void IKRigUtils::FPoseToLocal(SoulSkeleton& sk, std::vector<FTransform>& globalpose, const FTransform& rootConvert, std::vector<FTransform>& localpose) {
+    assert(sk.joints.size() == globalpose.size());
+    localpose.resize(globalpose.size());
+
+    // only the root carries the coord, children stay relative to the unconverted parents
+    TransformKernel::Multiply(localpose[0], globalpose[0], rootConvert);
+    for(int jointId = 1; jointId < globalpose.size(); jointId++) {
+        int parentId = sk.joints[jointId].parentId;
+        assert(parentId < jointId);
+        TransformKernel::Relative(localpose[jointId], globalpose[jointId], globalpose[parentId]);
+    }
+}
+
+void IKRigUtils::FPoseToGlobal(SoulSkeleton& sk, const FTransform& rootConvert, std::vector<FTransform>& localpose, std::vector<FTransform>& globalpose) {
+    assert(sk.joints.size() == localpose.size());
+    globalpose.resize(localpose.size());
+
+    TransformKernel::Multiply(globalpose[0], localpose[0], rootConvert);
+    for(int jointId = 1; jointId < localpose.size(); jointId++) {
+        int parentId = sk.joints[jointId].parentId;
+        assert(parentId < jointId);
+        TransformKernel::Multiply(globalpose[jointId], localpose[jointId], globalpose[parentId]);
+    }
+}
+
+void IKRigUtils::getBoneLevels(SoulSkeleton& sk, FBoneLevels& levels) {
+    std::vector<int32_t> parentIds(sk.joints.size());
+    for(int jointId = 0; jointId < sk.joints.size(); jointId++) {
+        parentIds[jointId] = sk.joints[jointId].parentId;
+    }
+    levels.Initialize(parentIds);
+}
+
+void IKRigUtils::FPoseToGlobal(const FBoneLevels& levels, std::vector<FTransform>& localpose, std::vector<FTransform>& globalpose, int32_t parallelMinBones) {
+    assert(levels.Bones.size() == localpose.size());
+    globalpose.resize(localpose.size());
+    levels.LocalToGlobal(localpose.data(), globalpose.data(), INDEX_NONE, parallelMinBones);
+}
+
+void IKRigUtils::FPoseToLocal(const FBoneLevels& levels, std::vector<FTransform>& globalpose, std::vector<FTransform>& localpose, int32_t parallelMinBones) {
+    assert(levels.Bones.size() == globalpose.size());
+    localpose.resize(globalpose.size());
+    levels.GlobalToLocal(globalpose.data(), localpose.data(), parallelMinBones);
+}
+
+void IKRigUtils::FPoseToLocal(SoulSkeleton& sk, FPoseSoA& globalpose, FPoseSoA& localpose) {
+    assert(sk.joints.size() == globalpose.Num());
+    localpose.SetNum(globalpose.Num());
+
+    localpose.SetTransform(0, globalpose.GetTransform(0));
+    for(int jointId = 1; jointId < globalpose.Num(); jointId++) {
+        int parentId = sk.joints[jointId].parentId;
+        assert(parentId < jointId);
+        TransformKernel::Relative(
+            localpose.Rotations[jointId], localpose.Translations[jointId], localpose.Scales[jointId],
+            globalpose.Rotations[jointId], globalpose.Translations[jointId], globalpose.Scales[jointId],
+            globalpose.Rotations[parentId], globalpose.Translations[parentId], globalpose.Scales[parentId]);
+    }
+}
+
+void IKRigUtils::FPoseToGlobal(SoulSkeleton& sk, FPoseSoA& localpose, FPoseSoA& globalpose) {
+    assert(sk.joints.size() == localpose.Num());
+    globalpose.SetNum(localpose.Num());
+
+    globalpose.SetTransform(0, localpose.GetTransform(0));
+    for(int jointId = 1; jointId < localpose.Num(); jointId++) {
+        int parentId = sk.joints[jointId].parentId;
+        assert(parentId < jointId);
+        TransformKernel::Multiply(
+            globalpose.Rotations[jointId], globalpose.Translations[jointId], globalpose.Scales[jointId],
+            localpose.Rotations[jointId], localpose.Translations[jointId], localpose.Scales[jointId],
+            globalpose.Rotations[parentId], globalpose.Translations[parentId], globalpose.Scales[parentId]);
     }
 }
 
@@ -446,6 +564,7 @@ void IKRigUtils::SoulPoseToLocal(SoulSkeleton& sk, std::vector<SoulTransform>& g
     localpose[0] = globalpose[0];
     for(int jointId = 1; jointId < globalpose.size(); jointId++) {
         int parentId = sk.joints[jointId].parentId;
+        assert(parentId < jointId);
         // gchild = gparent * lchild => lchild = gparent.inv * gchild
         localpose[jointId] =  globalpose[jointId].GetRelativeTransform(globalpose[parentId]);
         //SoulTransform(glm::inverse(globalpose[parentId].toMatrix()) * globalpose[jointId].toMatrix());
@@ -463,6 +582,7 @@ std::vector<SoulTransform> IKRigUtils::SoulPoseToGlobal(SoulSkeleton& sk, std::v
     globalpose[0] = localpose[0];
     for(int jointId = 1; jointId < localpose.size(); jointId++) {
         int parentId = sk.joints[jointId].parentId;
+        assert(parentId < jointId);
         globalpose[jointId] = globalpose[parentId] * localpose[jointId];
     }
 
@@ -487,6 +607,24 @@ void IKRigUtils::FPose2SoulPose(std::vector<FTransform>& pose, SoulIK::SoulPose&
     }
 }
 
+void IKRigUtils::SoulPose2FPose(SoulIK::SoulPose& soulpose, FPoseSoA& pose) {
+    pose.SetNum(soulpose.transforms.size());
+    for(int i = 0; i < soulpose.transforms.size(); i++) {
+        pose.Translations[i] = FVector(soulpose.transforms[i].translation);
+        pose.Rotations[i] = FQuat(soulpose.transforms[i].rotation);
+        pose.Scales[i] = FVector(soulpose.transforms[i].scale);
+    }
+}
+
+void IKRigUtils::FPose2SoulPose(FPoseSoA& pose, SoulIK::SoulPose& soulpose) {
+    soulpose.transforms.resize(pose.Num());
+    for(int i = 0; i < soulpose.transforms.size(); i++) {
+        soulpose.transforms[i].translation = pose.Translations[i];
+        soulpose.transforms[i].rotation = pose.Rotations[i];
+        soulpose.transforms[i].scale = pose.Scales[i];
+    }
+}
+
 SoulTransform IKRigUtils::glmToSoulTransform(glm::mat4& m) {
     return SoulTransform(m);
 }
@@ -498,21 +636,41 @@ FTransform IKRigUtils::glmToFTransform(glm::mat4& m) {
 bool IKRigUtils::alignUSKWithSkeleton(USkeleton& usk, SoulSkeleton const& sk, SoulScene& uskScene, SoulScene&skScene) {
 
     assert(usk.boneTree.size() == sk.joints.size());
+    if (usk.boneTree.size() != sk.joints.size()) {
+        printf("*** error: TPose model has %zu bones, animation model %zu joints\n", usk.boneTree.size(), sk.joints.size());
+        return false;
+    }
 
-    // sort bone tree and refpose
+    // reorder bone tree and refpose to the skeleton order, one lookup per bone
+    // (the hierarchy order used by the retargeter is derived from parentId later, see FBoneHierarchy)
+    // the result must be a permutation: every usk bone placed once, so bone names have to be unique
+    std::unordered_map<std::string, size_t> uskIndexByName;
+    for (size_t i = 0; i < usk.boneTree.size(); i++) {
+        if (!uskIndexByName.emplace(usk.boneTree[i].name, i).second) {
+            printf("*** error: bone %s twice in TPose model\n", usk.boneTree[i].name.c_str());
+            return false;
+        }
+    }
+    std::vector<FBoneNode> boneTree = usk.boneTree;
+    std::vector<FTransform> refpose = usk.refpose;
+    std::vector<bool> placed(usk.boneTree.size(), false);
     for (size_t i = 0; i < sk.joints.size(); i++) {
-        auto& name = sk.joints[i].name;
-        // if name not same, find and swap with it
-        if (usk.boneTree[i].name != name) {
-            for (size_t j = i + 1; j < sk.joints.size(); j++) {
-                if (usk.boneTree[j].name == name) {
-                    std::swap(*(usk.boneTree.begin() + i), *(usk.boneTree.begin() + j));
-                    std::swap(*(usk.refpose.begin() + i), *(usk.refpose.begin() + j));
-                    break;
-                }
-            }
+        auto it = uskIndexByName.find(sk.joints[i].name);
+        if (it == uskIndexByName.end()) {
+            // no bone to put in slot i, the usk would keep a stale copy of one at another index
+            printf("*** error: joint %s not in TPose model\n", sk.joints[i].name.c_str());
+            return false;
         }
+        if (placed[it->second]) {
+            printf("*** error: joint %s twice in animation model\n", sk.joints[i].name.c_str());
+            return false;
+        }
+        placed[it->second] = true;
+        boneTree[i] = usk.boneTree[it->second];
+        refpose[i] = usk.refpose[it->second];
     }
+    usk.boneTree.swap(boneTree);
+    usk.refpose.swap(refpose);
 
     // build parentId
     for (size_t i = 0; i < sk.joints.size(); i++) {
@@ -520,23 +678,23 @@ bool IKRigUtils::alignUSKWithSkeleton(USkeleton& usk, SoulSkeleton const& sk, So
     }
 
     // align scale
-    SoulNode* srcRoot = uskScene.findNodeByName(sk.joints[0].name).get();
-    SoulNode* tgtRoot = skScene.findNodeByName(sk.joints[0].name).get();
+    SoulNode* srcRoot = uskScene.findNodeByName(sk.joints[0].name);
+    SoulNode* tgtRoot = skScene.findNodeByName(sk.joints[0].name);
 
     glm::vec3 srcScale(1.0);
-    SoulNode* curNode = srcRoot->parent;
+    SoulNode* curNode = uskScene.getParent(*srcRoot);
     while(curNode != nullptr) {
         SoulTransform tf(curNode->transform);
         srcScale *= tf.scale;
-        curNode = curNode->parent;
+        curNode = uskScene.getParent(*curNode);
     }
 
     glm::vec3 tgtScale(1.0);
-    curNode = tgtRoot->parent;
+    curNode = skScene.getParent(*tgtRoot);
     while(curNode != nullptr) {
         SoulTransform tf(curNode->transform);
         tgtScale *= tf.scale;
-        curNode = curNode->parent;
+        curNode = skScene.getParent(*curNode);
     }
 
     glm::vec3 deltaScale = srcScale / tgtScale;
@@ -553,20 +711,6 @@ bool IKRigUtils::alignUSKWithSkeleton(USkeleton& usk, SoulSkeleton const& sk, So
     return true;
 }
 
-SoulNode* IKRigUtils::findNodeByName(SoulNode* rootNode, std::string& name) {
-    if (rootNode->name == name) {
-        return rootNode;
-    }
-
-    for(auto& child : rootNode->children) {
-        auto ret = findNodeByName(child.get(), name);
-        if (ret != nullptr) {
-            return ret;
-        }
-    }
-    return nullptr;
-}
-
 bool IKRigUtils::getUSkeletonFromMesh(SoulScene& scene, SoulSkeletonMesh& skmesh, USkeleton& usk, CoordType srcCoord, CoordType tgtCoord) {
 
     SoulSkeleton& sk = skmesh.skeleton;
@@ -590,10 +734,10 @@ bool IKRigUtils::getUSkeletonFromMesh(SoulScene& scene, SoulSkeletonMesh& skmesh
     // refpose is local
     usk.refpose.clear();
     for(uint64_t i = 0; i < joints.size(); i++) {
-        std::string name = joints[i].name;
+        const std::string& name = joints[i].name;
 
         // find node
-        auto node = IKRigUtils::findNodeByName(scene.rootNode.get(), name);
+        SoulNode* node = scene.findNodeByName(name);
         glm::mat4 m = node->transform;
         FTransform t;
 
@@ -608,7 +752,7 @@ bool IKRigUtils::getUSkeletonFromMesh(SoulScene& scene, SoulSkeletonMesh& skmesh
     }
 
     if (srcCoord != tgtCoord && usk.refpose.size() != 0) {
-        FTransform t = getFTransformFromCoord(srcCoord, tgtCoord);
+        const FTransform& t = getFTransformFromCoord(srcCoord, tgtCoord);
         usk.refpose[0] = usk.refpose[0] * t;
     } else if (srcCoord == tgtCoord) {
         // do nothing
@@ -650,10 +794,10 @@ std::vector<SoulTransform> IKRigUtils::getSoulPoseTransformFromMesh(SoulScene& s
     // refpose
     pose.clear();
     for(uint64_t i = 0; i < joints.size(); i++) {
-        std::string name = joints[i].name;
+        const std::string& name = joints[i].name;
 
         // find node
-        auto node = IKRigUtils::findNodeByName(scene.rootNode.get(), name);
+        SoulNode* node = scene.findNodeByName(name);
         glm::mat4 m = node->transform;
         SoulTransform t;
 
@@ -680,10 +824,10 @@ SoulPose IKRigUtils::getSoulPoseFromMesh(SoulScene& scene, SoulSkeletonMesh& skm
     // refpose is local
     outpose.transforms.clear();
     for(uint64_t i = 0; i < joints.size(); i++) {
-        std::string name = joints[i].name;
+        const std::string& name = joints[i].name;
 
         // find node
-        auto node = IKRigUtils::findNodeByName(scene.rootNode.get(), name);
+        SoulNode* node = scene.findNodeByName(name);
         glm::mat4 m = node->transform;
         glm::vec3 scale, translation, skew;
         glm::vec4 perspective;
@@ -771,7 +915,7 @@ void IKRigUtils::debugPrintLocalFPose(SoulSkeleton& sk, std::vector<FTransform>&
     }
 }
 
-static void debugPrintNodePoseRecursive(SoulNode* rootNode, const glm::mat4& parentM, int depth) {
+static void debugPrintNodePoseRecursive(SoulScene& scene, SoulNode* rootNode, const glm::mat4& parentM, int depth) {
 
     if(rootNode == nullptr) {
         return;
@@ -799,13 +943,16 @@ static void debugPrintNodePoseRecursive(SoulNode* rootNode, const glm::mat4& par
         rootNode->name.c_str(), 
         lt.x, lt.y, lt.z, eu.x, eu.y, eu.z, ls.x, ls.y, ls.z, gt.x, gt.y, gt.z);
 
-    for(auto& child : rootNode->children) {
-        debugPrintNodePoseRecursive(child.get(), gm, depth+1);
+    for(int32_t child : scene.getChildren(*rootNode)) {
+        debugPrintNodePoseRecursive(scene, &scene.nodes[child], gm, depth+1);
     }
 }
 
-void IKRigUtils::debugPrintNodePose(SoulNode* rootNode) {
-    debugPrintNodePoseRecursive(rootNode, rootNode->transform, 0);
+void IKRigUtils::debugPrintNodePose(SoulScene& scene) {
+    SoulNode* rootNode = scene.getRootNode();
+    if (rootNode != nullptr) {
+        debugPrintNodePoseRecursive(scene, rootNode, rootNode->transform, 0);
+    }
 }
 
 void IKRigUtils::debugPrintUSKNames(USkeleton& usk) {
@@ -970,7 +1117,7 @@ void IKRigUtils::debugPrintUSkeletonTreeGTransform(SoulSkeleton& sk, USkeleton&
     }
 }
 
-void IKRigUtils::debugPrintNodeTree(SoulNode* node, int depth) {
+void IKRigUtils::debugPrintNodeTree(SoulScene& scene, SoulNode* node, int depth) {
     for(int i = 0; i < depth; i++) {
         if (i == depth-1) {
             printf("|----");
@@ -985,8 +1132,8 @@ void IKRigUtils::debugPrintNodeTree(SoulNode* node, int depth) {
         tf.translation.x, tf.translation.y, tf.translation.z, 
         tf.rotation.x, tf.rotation.y, tf.rotation.z, tf.rotation.w
     );
-    for(auto& child : node->children) {
-        debugPrintNodeTree(child.get(), depth+1);
+    for(int32_t child : scene.getChildren(*node)) {
+        debugPrintNodeTree(scene, &scene.nodes[child], depth+1);
     }
 }
 
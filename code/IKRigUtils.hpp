@@ -9,11 +9,16 @@
 
 #include "SoulScene.hpp"
 #include "SoulRetargeter.h"
+#include "SoulPoseSoA.h"
+#include "SoulBoneHierarchy.h"
 
 // SoulScene only for general data represent, not for data process and render
 // you should define your native scene data structure for your processor or renderer
 namespace SoulIK {
 
+    struct FRetargetPlan;
+    struct FIKRigLogger;
+
     // class CoordType
     // {
     // public:
@@ -104,6 +109,12 @@ namespace SoulIK {
         static std::shared_ptr<UIKRetargeter> createIKRigAsset(SoulIKRigRetargetConfig& config,
             SoulSkeleton& srcsk, SoulSkeleton& tgtsk, USkeleton& srcusk, USkeleton& tgtusk
         );
+        // initialized plan of createIKRigAsset, shared through FRetargetPlanCache while config and uskeletons are unchanged
+        // srcsk / tgtsk only fill the chain bone indices of the asset, the plan finds chain bones by name
+        static uint64_t hashRetargetInputs(SoulIKRigRetargetConfig const& config, USkeleton const& srcusk, USkeleton const& tgtusk);
+        static std::shared_ptr<const FRetargetPlan> getRetargetPlan(SoulIKRigRetargetConfig& config,
+            SoulSkeleton& srcsk, SoulSkeleton& tgtsk, USkeleton& srcusk, USkeleton& tgtusk, FIKRigLogger& log
+        );
 
         // coord convert
         static std::string CoordTypeToString(CoordType aCoordType);
@@ -111,7 +122,7 @@ namespace SoulIK {
         
         static void USkeletonCoordConvert(CoordType srcCoord, CoordType tgtCoord, USkeleton& sk);
         
-        static FTransform getFTransformFromCoord(CoordType srcCoord, CoordType tgtCoord);
+        static const FTransform& getFTransformFromCoord(CoordType srcCoord, CoordType tgtCoord); // precomputed, no trig per call
         static bool LocalFPoseCoordConvert(CoordType srcCoord, CoordType tgtCoord, std::vector<FTransform>& pose);
         static bool GlobalFPoseCoordConvert(CoordType srcCoord, CoordType tgtCoord, std::vector<FTransform>& pose);
         static bool LocalFPoseCoordConvert(FTransform& t, CoordType srcCoord, CoordType tgtCoord, std::vector<FTransform>& pose);
@@ -128,10 +139,25 @@ namespace SoulIK {
         static void FPoseToGlobal(SoulSkeleton& sk, std::vector<FTransform>& localpose, std::vector<FTransform>& globalpose);
         static void SoulPoseToLocal(SoulSkeleton& sk, std::vector<SoulTransform>& globalpose, std::vector<SoulTransform>& localpose);
         static std::vector<SoulTransform> SoulPoseToGlobal(SoulSkeleton& sk, std::vector<SoulTransform>& localpose);
+        static void FPoseToLocal(SoulSkeleton& sk, FPoseSoA& globalpose, FPoseSoA& localpose);
+        static void FPoseToGlobal(SoulSkeleton& sk, FPoseSoA& localpose, FPoseSoA& globalpose);
+        // fused with LocalFPoseCoordConvert: rootConvert (getFTransformFromCoord) is applied to the root in the same pass
+        //   FPoseToGlobal: source local pose -> work coord global pose
+        //   FPoseToLocal:  work coord global pose -> target local pose
+        static void FPoseToGlobal(SoulSkeleton& sk, const FTransform& rootConvert, std::vector<FTransform>& localpose, std::vector<FTransform>& globalpose);
+        static void FPoseToLocal(SoulSkeleton& sk, std::vector<FTransform>& globalpose, const FTransform& rootConvert, std::vector<FTransform>& localpose);
+        // level order variants for very large skeletons (thousands of joints), same result as the forward pass
+        //   levels: from getBoneLevels(sk), built once per skeleton
+        //   parallelMinBones: levels with at least this many joints go to the worker threads (SoulParallel.h), -1 never
+        static void getBoneLevels(SoulSkeleton& sk, FBoneLevels& levels);
+        static void FPoseToGlobal(const FBoneLevels& levels, std::vector<FTransform>& localpose, std::vector<FTransform>& globalpose, int32_t parallelMinBones = -1);
+        static void FPoseToLocal(const FBoneLevels& levels, std::vector<FTransform>& globalpose, std::vector<FTransform>& localpose, int32_t parallelMinBones = -1);
 
         // pose struct cast
         static void SoulPose2FPose(SoulPose& soulpose, std::vector<FTransform>& pose);
         static void FPose2SoulPose(std::vector<FTransform>& pose, SoulPose& soulpose);
+        static void SoulPose2FPose(SoulPose& soulpose, FPoseSoA& pose);
+        static void FPose2SoulPose(FPoseSoA& pose, SoulPose& soulpose);
 
         // transform cast
         SoulTransform glmToSoulTransform(glm::mat4& m);
@@ -143,9 +169,6 @@ namespace SoulIK {
         static std::vector<SoulJointNode> buildJointTree(SoulSkeleton& sk);
         static bool alignUSKWithSkeleton(USkeleton& usk, SoulSkeleton const& sk, SoulScene& uskScene, SoulScene&skScene);
 
-        // search
-        static SoulNode* findNodeByName(SoulNode* rootNode, std::string& name);
-
         // get pose
         static std::vector<SoulTransform> getSoulPoseTransformFromMesh(SoulScene& scene, SoulSkeletonMesh& skmesh);
         static SoulPose getSoulPoseFromMesh(SoulScene& scene, SoulSkeletonMesh& skmesh);
@@ -155,7 +178,7 @@ namespace SoulIK {
         static void debugPrintFPose(SoulSkeleton& sk, std::vector<FTransform>& pose, std::vector<FTransform>& initpose);
         static void debugPrintSoulPose(SoulSkeleton& sk, std::vector<SoulTransform>& pose);
         static void debugPrintLocalFPose(SoulSkeleton& sk, std::vector<FTransform>& pose);
-        static void debugPrintNodePose(SoulNode* rootNode);
+        static void debugPrintNodePose(SoulScene& scene);
         static void debugPrintUSKNames(USkeleton& usk);
         // name tree
         static void debugPrintSkeletonTree(SoulSkeleton& sk);
@@ -163,7 +186,7 @@ namespace SoulIK {
         static void debugPrintSkeletonTreeTransform(SoulScene& scene, SoulSkeletonMesh& skmesh);
         static void debugPrintSkeletonTreeGTransform(SoulScene& scene, SoulSkeletonMesh& skmesh);
         static void debugPrintUSkeletonTreeGTransform(SoulSkeleton& sk, USkeleton& usk);
-        static void debugPrintNodeTree(SoulNode* node, int depth = 0);
+        static void debugPrintNodeTree(SoulScene& scene, SoulNode* node, int depth = 0);
         // TRS of some joints
         static void debugPrintPoseJoints(const std::string& prefix, SoulSkeleton& sk, std::vector<FTransform>& inpose, std::vector<std::string> jointNames);
 
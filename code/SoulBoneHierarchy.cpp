@@ -0,0 +1,250 @@
+//
+//  SoulBoneHierarchy.cpp
+//
+//  validated flat bone hierarchy, parents before children, with remap to file order
+//
+
+#include "SoulBoneHierarchy.h"
+#include "SoulFTransformBatch.h"
+#include "SoulParallel.h"
+#include <cassert>
+
+namespace
+{
+    // bones per chunk when a level goes to the worker threads
+    constexpr SoulIK::int32 LevelBatchSize = 64;
+}
+
+namespace SoulIK
+{
+    const char* HierarchyErrorToString(EHierarchyError Error)
+    {
+        switch (Error)
+        {
+            case EHierarchyError::None: return "None";
+            case EHierarchyError::ParentOutOfRange: return "ParentOutOfRange";
+            case EHierarchyError::Cycle: return "Cycle";
+        }
+        return "Unknown";
+    }
+
+    void FBoneHierarchy::Reset()
+    {
+        ParentIndices.clear();
+        SubtreeEnd.clear();
+        SortedToFile.clear();
+        FileToSorted.clear();
+        bIsFileOrder = true;
+    }
+
+    EHierarchyError FBoneHierarchy::Initialize(const TArray<int32>& FileParentIndices, int32* OutErrorBone)
+    {
+        Reset();
+
+        const int32 NumBones = (int32)FileParentIndices.size();
+        for (int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex)
+        {
+            const int32 ParentIndex = FileParentIndices[BoneIndex];
+            if (ParentIndex != INDEX_NONE && (ParentIndex < 0 || ParentIndex >= NumBones || ParentIndex == BoneIndex))
+            {
+                if (OutErrorBone)
+                {
+                    *OutErrorBone = BoneIndex;
+                }
+                return EHierarchyError::ParentOutOfRange;
+            }
+        }
+
+        // children of each bone in file order, packed: Children[ChildStart[i] .. ChildStart[i+1])
+        TArray<int32> ChildStart(NumBones + 1, 0);
+        for (const int32 ParentIndex : FileParentIndices)
+        {
+            if (ParentIndex != INDEX_NONE)
+            {
+                ++ChildStart[ParentIndex + 1];
+            }
+        }
+        for (int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex)
+        {
+            ChildStart[BoneIndex + 1] += ChildStart[BoneIndex];
+        }
+        TArray<int32> Children(ChildStart[NumBones]);
+        TArray<int32> Fill(ChildStart.begin(), ChildStart.end() - 1);
+        for (int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex)
+        {
+            const int32 ParentIndex = FileParentIndices[BoneIndex];
+            if (ParentIndex != INDEX_NONE)
+            {
+                Children[Fill[ParentIndex]++] = BoneIndex;
+            }
+        }
+
+        // depth first from every root, bones on a cycle are never reached
+        SortedToFile.reserve(NumBones);
+        TArray<int32> Stack;
+        for (int32 RootIndex = 0; RootIndex < NumBones; ++RootIndex)
+        {
+            if (FileParentIndices[RootIndex] != INDEX_NONE)
+            {
+                continue;
+            }
+            Stack.push_back(RootIndex);
+            while (!Stack.empty())
+            {
+                const int32 BoneIndex = Stack.back();
+                Stack.pop_back();
+                SortedToFile.push_back(BoneIndex);
+                for (int32 ChildIndex = ChildStart[BoneIndex + 1] - 1; ChildIndex >= ChildStart[BoneIndex]; --ChildIndex)
+                {
+                    Stack.push_back(Children[ChildIndex]);
+                }
+            }
+        }
+
+        FileToSorted.assign(NumBones, INDEX_NONE);
+        for (int32 SortedIndex = 0; SortedIndex < SortedToFile.size(); ++SortedIndex)
+        {
+            FileToSorted[SortedToFile[SortedIndex]] = SortedIndex;
+        }
+
+        if (SortedToFile.size() != NumBones)
+        {
+            if (OutErrorBone)
+            {
+                *OutErrorBone = (int32)(std::find(FileToSorted.begin(), FileToSorted.end(), INDEX_NONE) - FileToSorted.begin());
+            }
+            Reset();
+            return EHierarchyError::Cycle;
+        }
+
+        ParentIndices.resize(NumBones);
+        for (int32 SortedIndex = 0; SortedIndex < NumBones; ++SortedIndex)
+        {
+            const int32 FileIndex = SortedToFile[SortedIndex];
+            const int32 ParentIndex = FileParentIndices[FileIndex];
+            ParentIndices[SortedIndex] = ParentIndex == INDEX_NONE ? INDEX_NONE : FileToSorted[ParentIndex];
+            bIsFileOrder = bIsFileOrder && FileIndex == SortedIndex;
+        }
+
+        // children come after their parent, so accumulating backwards visits every subtree before its root
+        SubtreeEnd.resize(NumBones);
+        for (int32 SortedIndex = 0; SortedIndex < NumBones; ++SortedIndex)
+        {
+            SubtreeEnd[SortedIndex] = SortedIndex + 1;
+        }
+        for (int32 SortedIndex = NumBones - 1; SortedIndex > 0; --SortedIndex)
+        {
+            const int32 ParentIndex = ParentIndices[SortedIndex];
+            if (ParentIndex != INDEX_NONE)
+            {
+                SubtreeEnd[ParentIndex] = std::max(SubtreeEnd[ParentIndex], SubtreeEnd[SortedIndex]);
+            }
+        }
+
+        return EHierarchyError::None;
+    }
+
+    void FBoneLevels::Reset()
+    {
+        LevelOffsets.clear();
+        Bones.clear();
+        Parents.clear();
+    }
+
+    void FBoneLevels::Initialize(const TArray<int32>& ParentIndices)
+    {
+        Reset();
+
+        const int32 NumBones = (int32)ParentIndices.size();
+        TArray<int32> Depths(NumBones, 0);
+        int32 MaxDepth = NumBones > 0 ? 0 : INDEX_NONE;
+        for (int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex)
+        {
+            const int32 ParentIndex = ParentIndices[BoneIndex];
+            assert(ParentIndex < BoneIndex);
+            Depths[BoneIndex] = ParentIndex == INDEX_NONE ? 0 : Depths[ParentIndex] + 1;
+            MaxDepth = std::max(MaxDepth, Depths[BoneIndex]);
+        }
+
+        // counting sort by depth, stable so bones stay ascending inside a level
+        LevelOffsets.assign(MaxDepth + 2, 0);
+        for (const int32 Depth : Depths)
+        {
+            ++LevelOffsets[Depth + 1];
+        }
+        for (int32 Level = 0; Level <= MaxDepth; ++Level)
+        {
+            LevelOffsets[Level + 1] += LevelOffsets[Level];
+        }
+        Bones.resize(NumBones);
+        Parents.resize(NumBones);
+        TArray<int32> Fill(LevelOffsets.begin(), LevelOffsets.end() - 1);
+        for (int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex)
+        {
+            const int32 Slot = Fill[Depths[BoneIndex]]++;
+            Bones[Slot] = BoneIndex;
+            Parents[Slot] = ParentIndices[BoneIndex];
+        }
+    }
+
+    void FBoneLevels::LocalToGlobal(const FTransform* Local, FTransform* Global, int32 StartBone, int32 ParallelMinBones) const
+    {
+        for (int32 Level = 0; Level < NumLevels(); ++Level)
+        {
+            const int32* LevelBegin = Bones.data() + LevelOffsets[Level];
+            const int32* LevelEnd = Bones.data() + LevelOffsets[Level + 1];
+            const int32 Begin = (int32)(std::upper_bound(LevelBegin, LevelEnd, StartBone) - Bones.data());
+            const int32 Num = LevelOffsets[Level + 1] - Begin;
+
+            if (Level == 0)
+            {
+                // roots always in global space already
+                for (int32 Slot = Begin; Slot < Begin + Num; ++Slot)
+                {
+                    Global[Bones[Slot]] = Local[Bones[Slot]];
+                }
+                continue;
+            }
+
+            if (ParallelMinBones != INDEX_NONE && Num >= ParallelMinBones)
+            {
+                ParallelFor(Num, LevelBatchSize, [&](int32 ChunkBegin, int32 ChunkEnd)
+                {
+                    MultiplyParentN(Global, Local, Bones.data() + Begin + ChunkBegin, Parents.data() + Begin + ChunkBegin, ChunkEnd - ChunkBegin);
+                });
+            }
+            else
+            {
+                MultiplyParentN(Global, Local, Bones.data() + Begin, Parents.data() + Begin, Num);
+            }
+        }
+    }
+
+    void FBoneLevels::GlobalToLocal(const FTransform* Global, FTransform* Local, int32 ParallelMinBones) const
+    {
+        if (NumLevels() == 0)
+        {
+            return;
+        }
+
+        for (int32 Slot = 0; Slot < LevelOffsets[1]; ++Slot)
+        {
+            Local[Bones[Slot]] = Global[Bones[Slot]];
+        }
+
+        // every level after the roots in one batch
+        const int32 Begin = LevelOffsets[1];
+        const int32 Num = (int32)Bones.size() - Begin;
+        if (ParallelMinBones != INDEX_NONE && Num >= ParallelMinBones)
+        {
+            ParallelFor(Num, LevelBatchSize, [&](int32 ChunkBegin, int32 ChunkEnd)
+            {
+                RelativeParentN(Local, Global, Bones.data() + Begin + ChunkBegin, Parents.data() + Begin + ChunkBegin, ChunkEnd - ChunkBegin);
+            });
+        }
+        else
+        {
+            RelativeParentN(Local, Global, Bones.data() + Begin, Parents.data() + Begin, Num);
+        }
+    }
+}
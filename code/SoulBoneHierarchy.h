@@ -0,0 +1,120 @@
+//
+//  SoulBoneHierarchy.h
+//
+//  validated flat bone hierarchy, parents before children, with remap to file order
+//
+
+#pragma once
+
+#include "SoulFTransform.h"
+
+namespace SoulIK
+{
+    enum class EHierarchyError : uint8_t
+    {
+        None,
+        ParentOutOfRange,       // parent index is not INDEX_NONE and not a bone, or the bone itself
+        Cycle,                  // bone never reaches a root
+    };
+
+    const char* HierarchyErrorToString(EHierarchyError Error);
+
+    // bones in depth first order: every parent comes before its children and every subtree is contiguous,
+    // siblings keep their file order, so a hierarchy that is already sorted maps to itself
+    //   sorted index: index into ParentIndices and into any pose converted with ToSorted()
+    //   file index:   index into the parent array the hierarchy was built from (skeleton / fbx order)
+    // a global/local conversion over sorted poses is a single forward pass: ParentIndices[i] < i
+    // the subtree of bone i is the sorted range [i, SubtreeEnd[i]), so descendant queries need no walk
+    // everything is filled by Initialize(), a const hierarchy can be queried from any thread
+    struct FBoneHierarchy
+    {
+        TArray<int32> ParentIndices;    // sorted index -> sorted parent index, INDEX_NONE for roots
+        TArray<int32> SubtreeEnd;       // sorted index -> one past the last bone below it
+        TArray<int32> SortedToFile;
+        TArray<int32> FileToSorted;
+
+        // @param FileParentIndices - parent of each bone in file order, INDEX_NONE for roots
+        // @param OutErrorBone - file index of the first offending bone on failure
+        // @return None on success, on failure the hierarchy is left empty
+        EHierarchyError Initialize(const TArray<int32>& FileParentIndices, int32* OutErrorBone = nullptr);
+
+        void Reset();
+
+        int32 Num() const { return (int32)ParentIndices.size(); }
+
+        // true if sorted and file order are the same, then no pose needs remapping
+        bool IsFileOrder() const { return bIsFileOrder; }
+
+        // true if Bone is below Ancestor, false for the bone itself (sorted indices)
+        bool IsDescendant(const int32 Ancestor, const int32 Bone) const
+        {
+            return Ancestor < Bone && Bone < SubtreeEnd[Ancestor];
+        }
+
+        // number of bones below Bone, 0 for a leaf
+        int32 NumDescendants(const int32 Bone) const { return SubtreeEnd[Bone] - Bone - 1; }
+
+        // Out[sorted] = In[file]
+        template<typename T>
+        void ToSorted(const TArray<T>& InFilePose, TArray<T>& OutSortedPose) const
+        {
+            OutSortedPose.resize(SortedToFile.size());
+            ToSorted(InFilePose.data(), OutSortedPose.data());
+        }
+
+        // same as above for poses of Num() transforms
+        template<typename T>
+        void ToSorted(const T* InFilePose, T* OutSortedPose) const
+        {
+            for (int32 SortedIndex = 0; SortedIndex < SortedToFile.size(); ++SortedIndex)
+            {
+                OutSortedPose[SortedIndex] = InFilePose[SortedToFile[SortedIndex]];
+            }
+        }
+
+        // Out[file] = In[sorted]
+        template<typename T>
+        void ToFile(const TArray<T>& InSortedPose, TArray<T>& OutFilePose) const
+        {
+            OutFilePose.resize(SortedToFile.size());
+            ToFile(InSortedPose.data(), OutFilePose.data());
+        }
+
+        template<typename T>
+        void ToFile(const T* InSortedPose, T* OutFilePose) const
+        {
+            for (int32 SortedIndex = 0; SortedIndex < SortedToFile.size(); ++SortedIndex)
+            {
+                OutFilePose[SortedToFile[SortedIndex]] = InSortedPose[SortedIndex];
+            }
+        }
+
+    private:
+        bool bIsFileOrder = true;
+    };
+
+    // bones grouped by depth: every parent is in an earlier level than its children,
+    // so the bones of one level are independent and each level is evaluated as one batch
+    struct FBoneLevels
+    {
+        TArray<int32> LevelOffsets;     // level l is Bones[LevelOffsets[l] .. LevelOffsets[l+1]), level 0 holds the roots
+        TArray<int32> Bones;            // bone indices level by level, ascending inside a level
+        TArray<int32> Parents;          // parent of Bones[k]
+
+        // @param ParentIndices - parent of each bone, INDEX_NONE for roots, ParentIndices[i] < i
+        void Initialize(const TArray<int32>& ParentIndices);
+
+        void Reset();
+
+        int32 NumLevels() const { return LevelOffsets.empty() ? 0 : (int32)LevelOffsets.size() - 1; }
+
+        // Global[b] = Local[b] * Global[parent(b)] for every bone b > StartBone, the others are read from Global,
+        // same result as the forward pass over the bones in index order
+        // @param ParallelMinBones - levels with at least this many bones are split over the worker threads (SoulParallel.h),
+        //                           INDEX_NONE keeps every level on the calling thread
+        void LocalToGlobal(const FTransform* Local, FTransform* Global, int32 StartBone = INDEX_NONE, int32 ParallelMinBones = INDEX_NONE) const;
+
+        // Local[b] = Global[b] relative to Global[parent(b)], no level order is needed here, all bones are independent
+        void GlobalToLocal(const FTransform* Global, FTransform* Local, int32 ParallelMinBones = INDEX_NONE) const;
+    };
+}
@@ -0,0 +1,211 @@
+//
+//  SoulDualQuat.h
+//
+//  unit dual quaternion rigid transform, for rigs without scale
+//
+
+#pragma once
+
+#include "SoulFTransformBatch.h"
+
+namespace SoulIK
+{
+    // rotation + translation as Real + eps * Dual, Dual = 0.5 * (0, T) * Real
+    // same semantic as FTransform (child_global = child_local * parent_global), scale is not represented:
+    // converting from a transform drops Scale3D, converting back gives unit scale
+    template<typename T>
+    struct TDualQuat
+    {
+        TQuat<T> Real;
+        TQuat<T> Dual;
+
+        static const TDualQuat Identity;
+
+        TDualQuat() : Real(TQuat<T>::Identity), Dual(0, 0, 0, 0) {}
+        TDualQuat(const TQuat<T>& InReal, const TQuat<T>& InDual) : Real(InReal), Dual(InDual) {}
+        TDualQuat(const TQuat<T>& Rotation, const TVector<T>& Translation)
+            : Real(Rotation)
+            , Dual(TQuat<T>(Translation.x, Translation.y, Translation.z, 0) * Rotation * T(0.5))
+        {
+        }
+        explicit TDualQuat(const TTransform<T>& Transform) : TDualQuat(Transform.Rotation, Transform.Translation) {}
+
+        TQuat<T> GetRotation() const { return Real; }
+
+        TVector<T> GetTranslation() const
+        {
+            const TQuat<T> Q = (Dual * glm::conjugate(Real)) * T(2);
+            return TVector<T>(Q.x, Q.y, Q.z);
+        }
+
+        TTransform<T> ToTransform() const
+        {
+            return TTransform<T>(Real, GetTranslation(), TVector<T>::OneVector);
+        }
+
+        // this first, then Other, like FTransform::operator*
+        TDualQuat operator*(const TDualQuat& Other) const
+        {
+            return TDualQuat(Other.Real * Real, TQuat<T>(Other.Real * Dual + Other.Dual * Real));
+        }
+
+        // valid for unit dual quaternions
+        TDualQuat Inverse() const
+        {
+            return TDualQuat(glm::conjugate(Real), glm::conjugate(Dual));
+        }
+
+        TVector<T> TransformPosition(const TVector<T>& V) const
+        {
+            return Real.RotateVector(V) + GetTranslation();
+        }
+
+        // unit length Real, Dual orthogonal to Real
+        void Normalize()
+        {
+            const T SquareSum = Real | Real;
+            if (SquareSum < UE_SMALL_NUMBER)
+            {
+                *this = Identity;
+                return;
+            }
+            const T Scale = T(1) / std::sqrt(SquareSum);
+            Real = Real * Scale;
+            Dual = Dual * Scale;
+            Dual = TQuat<T>(Dual - Real * (Real | Dual));
+        }
+
+        TDualQuat GetNormalized() const
+        {
+            TDualQuat Result(*this);
+            Result.Normalize();
+            return Result;
+        }
+
+        // dual quaternion linear blend along the shortest route, then normalized
+        // translation follows the screw motion between A and B rather than a straight line
+        static TDualQuat NLerp(const TDualQuat& A, const TDualQuat& B, const T Alpha)
+        {
+            const T Bias = (A.Real | B.Real) >= 0 ? T(1) : T(-1);
+            const T WeightA = Bias * (T(1) - Alpha);
+            TDualQuat Result(
+                TQuat<T>(A.Real * WeightA + B.Real * Alpha),
+                TQuat<T>(A.Dual * WeightA + B.Dual * Alpha));
+            Result.Normalize();
+            return Result;
+        }
+    };
+
+    // literal parts, TQuat<T>::Identity may not be initialized yet (see TTransform<T>::Identity)
+    template<typename T> const TDualQuat<T> TDualQuat<T>::Identity = TDualQuat<T>(TQuat<T>(0, 0, 0, 1), TQuat<T>(0, 0, 0, 0));
+
+    using FDualQuat = TDualQuat<FReal>;
+    using FDualQuat4f = TDualQuat<float>;
+    using FDualQuat4d = TDualQuat<double>;
+
+    namespace TransformKernel
+    {
+#if defined(SOULIK_SIMD_AVX2) || defined(SOULIK_SIMD_SSE4)
+
+        // Out = A * B: the two halves are 8 lanes of multiply-adds, no negative scale / matrix fallback
+        //   Real = B.Real * A.Real
+        //   Dual = B.Real * A.Dual + B.Dual * A.Real
+        template<typename T>
+        inline void Multiply(TDualQuat<T>& Out, const TDualQuat<T>& A, const TDualQuat<T>& B)
+        {
+            using V = typename TLanes<T>::Type;
+            const V ar = Load4(Ptr(A.Real));
+            const V ad = Load4(Ptr(A.Dual));
+            const V br = Load4(Ptr(B.Real));
+            const V bd = Load4(Ptr(B.Dual));
+
+            const V r = QuatMul(br, ar);
+            const V d = Add(QuatMul(br, ad), QuatMul(bd, ar));
+
+            Store4(Ptr(Out.Real), r);
+            Store4(Ptr(Out.Dual), d);
+        }
+
+        template<typename T>
+        inline void ToDualQuat(TDualQuat<T>& Out, const TTransform<T>& A)
+        {
+            using V = typename TLanes<T>::Type;
+            const V r = Load4(Ptr(A.Rotation));
+            const V t = SwapHalves(Shift123(Load3(Ptr(A.Translation))));     // 0 x y z
+            Store4(Ptr(Out.Dual), Mul(QuatMul(t, r), Splat<V>(T(0.5))));
+            Store4(Ptr(Out.Real), r);
+        }
+
+        template<typename T>
+        inline void ToTransform(TTransform<T>& Out, const TDualQuat<T>& A)
+        {
+            using V = typename TLanes<T>::Type;
+            const V r = Load4(Ptr(A.Real));
+            const V d = Load4(Ptr(A.Dual));
+            const V t = Mul(QuatMul(d, QuatConjugate(r)), Splat<V>(T(2)));  // 0 x y z
+            Store4(Ptr(Out.Rotation), r);
+            Store3(Ptr(Out.Translation), Shift123(t));
+            Out.Scale3D = TVector<T>::OneVector;
+        }
+
+        // TDualQuat::NLerp within the ReciprocalSqrt bound
+        template<typename T>
+        inline void NLerp(TDualQuat<T>& Out, const TDualQuat<T>& A, const TDualQuat<T>& B, const double InAlpha)
+        {
+            const T Alpha = T(InAlpha);
+            using V = typename TLanes<T>::Type;
+            const V ar = Load4(Ptr(A.Real));
+            const V ad = Load4(Ptr(A.Dual));
+            const V br = Load4(Ptr(B.Real));
+            const V bd = Load4(Ptr(B.Dual));
+
+            const T Bias = Lane0(Dot4(ar, br)) >= 0 ? T(1) : T(-1);
+            const V wa = Splat<V>(Bias * (T(1) - Alpha));
+            const V wb = Splat<V>(Alpha);
+            V r = MulAdd(ar, wa, Mul(br, wb));
+            V d = MulAdd(ad, wa, Mul(bd, wb));
+
+            const T SquareSum = Lane0(Dot4(r, r));
+            if (SquareSum < UE_SMALL_NUMBER)
+            {
+                Out = TDualQuat<T>::Identity;
+                return;
+            }
+            const V Scale = Splat<V>(ReciprocalSqrt(SquareSum));
+            r = Mul(r, Scale);
+            d = Mul(d, Scale);
+            d = Sub(d, Mul(r, Dot4(r, d)));
+
+            Store4(Ptr(Out.Real), r);
+            Store4(Ptr(Out.Dual), d);
+        }
+
+#else  // scalar
+
+        template<typename T>
+        inline void Multiply(TDualQuat<T>& Out, const TDualQuat<T>& A, const TDualQuat<T>& B)
+        {
+            Out = A * B;
+        }
+
+        template<typename T>
+        inline void ToDualQuat(TDualQuat<T>& Out, const TTransform<T>& A)
+        {
+            Out = TDualQuat<T>(A);
+        }
+
+        template<typename T>
+        inline void ToTransform(TTransform<T>& Out, const TDualQuat<T>& A)
+        {
+            Out = A.ToTransform();
+        }
+
+        template<typename T>
+        inline void NLerp(TDualQuat<T>& Out, const TDualQuat<T>& A, const TDualQuat<T>& B, const double Alpha)
+        {
+            Out = TDualQuat<T>::NLerp(A, B, T(Alpha));
+        }
+
+#endif
+    }
+}
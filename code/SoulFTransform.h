@@ -24,6 +24,8 @@
 #include "glm/ext/scalar_constants.hpp" // glm::pi
 #include "glm/gtx/matrix_decompose.hpp"
 
+#include "SoulName.h"
+
 
 // this file is adpater to glm
 // multiply order: https://docs.unrealengine.com/4.27/en-US/API/Runtime/Core/Math/FTransform/
@@ -41,12 +43,11 @@
 namespace SoulIK
 {
 
-    using FName = std::string;
     #define TArray std::vector
     using int32 = int32_t;
     #define TMap std::unordered_map
     #define INDEX_NONE  -1
-    #define NAME_None ""
+    #define NAME_None FName()
     #define KINDA_SMALL_NUMBER  (1.e-4f)
     #define UE_SMALL_NUMBER     (1.e-8f)
 
@@ -63,26 +64,35 @@ namespace SoulIK
 
     namespace FText {
         const char* FromName(std::string const& s);
+        const char* FromName(FName const& s);
     };
 
-    struct FVector;
-    FVector operator-(double Scale, const FVector& V);
-    struct FVector : public glm::dvec3 {
-        FVector(const glm::dvec3& v) : FVector(v.x, v.y, v.z) {}
-        FVector():FVector(0, 0, 0) {}
-        FVector(double _x, double _y, double _z): glm::dvec3(_x, _y, _z){}
-        FVector(double _x): glm::dvec3(_x) {}
-        static const FVector ZeroVector;
-        static const FVector OneVector;
+    template<typename T> struct TVector;
+    template<typename T> struct TRotator;
+    template<typename T> struct TQuat;
+    template<typename T> struct TTransform;
+
+    template<typename T>
+    struct TVector : public glm::vec<3, T> {
+        using glm::vec<3, T>::x;
+        using glm::vec<3, T>::y;
+        using glm::vec<3, T>::z;
+
+        TVector(const glm::vec<3, T>& v) : TVector(v.x, v.y, v.z) {}
+        TVector():TVector(0, 0, 0) {}
+        TVector(T _x, T _y, T _z): glm::vec<3, T>(_x, _y, _z){}
+        TVector(T _x): glm::vec<3, T>(_x) {}
+        static const TVector ZeroVector;
+        static const TVector OneVector;
 
         // Unit X axis vector (1,0,0)
-        static const FVector XAxisVector;
+        static const TVector XAxisVector;
 	    // Unit Y axis vector (0,1,0) 
-	    static const FVector YAxisVector;
+	    static const TVector YAxisVector;
 	    // Unit Z axis vector (0,0,1)
-	    static const FVector ZAxisVector;
+	    static const TVector ZAxisVector;
 
-        void Set(double InX, double InY, double InZ)
+        void Set(T InX, T InY, T InZ)
         {
             x = InX;
             y = InY;
@@ -90,98 +100,114 @@ namespace SoulIK
         }
 
 
-        FVector operator+(const FVector& V) const {
-            return FVector(x + V.x, y + V.y, z + V.z);
+        TVector operator+(const TVector& V) const {
+            return TVector(x + V.x, y + V.y, z + V.z);
         }
-        FVector operator-(const FVector& V) const {
-            return FVector(x - V.x, y - V.y, z - V.z);
+        TVector operator-(const TVector& V) const {
+            return TVector(x - V.x, y - V.y, z - V.z);
         }
-        FVector operator*(const double s) const {
-            return FVector(x * s, y * s, z * s);
+        TVector operator*(const T s) const {
+            return TVector(x * s, y * s, z * s);
         }
-        FVector operator*(const FVector& V) const {
-            return FVector(x * V.x, y * V.y, z * V.z);
+        TVector operator*(const TVector& V) const {
+            return TVector(x * V.x, y * V.y, z * V.z);
         }
-        FVector operator/(const double s) const {
-            return FVector(x / s, y / s, z / s);
+        TVector operator/(const T s) const {
+            return TVector(x / s, y / s, z / s);
         }
-        FVector operator+=(const FVector& V)
+        TVector operator+=(const TVector& V)
         {
             x += V.x; y += V.y; z += V.z;
             return *this;
         }
-        FVector operator-=(const FVector& V)
+        TVector operator-=(const TVector& V)
         {
             x -= V.x; y -= V.y; z -= V.z;
             return *this;
         }
-        FVector operator*=(const double& s)
+        TVector operator*=(const T& s)
         {
             x *= s; y *= s; z *= s;
             return *this;
         }
-        FVector operator*=(const FVector& V) {
+        TVector operator*=(const TVector& V) {
             x *= V.x; y *= V.y; z *= V.z;
             return *this;
         }
-        FVector operator/=(const double& s)
+        TVector operator/=(const T& s)
         {
             x /= s; y /= s; z /= s;
             return *this;
         }
 
 
-        // double Distance(FVector const& Other) {
+        // T Distance(TVector const& Other) {
         //     return (*this - Other).length();
         // }
-        double Size() const
+        T Size() const
         {
             return std::sqrt(x*x + y*y + z*z);
         }
 
-        double Length() const
+        T Length() const
         {
             return Size();
         }
 
-        double SizeSquared() const
+        T SizeSquared() const
         {
             return x*x + y*y + z*z;
         }
-        double SquaredLength() const
+        T SquaredLength() const
         {
             return SizeSquared();
         }
-        static FVector CrossProduct(const FVector& A, const FVector& B)
+        static TVector CrossProduct(const TVector& A, const TVector& B)
         {
-            glm::dvec3 C = glm::cross(A, B);
-            return FVector(C);
+            glm::vec<3, T> C = glm::cross(A, B);
+            return TVector(C);
         }
-        static FVector lerp(const FVector& A, const FVector& B, const double Alpha) {
-            return A * (1.0 - Alpha) + B * Alpha;
+        static TVector lerp(const TVector& A, const TVector& B, const T Alpha) {
+            return A * (T(1) - Alpha) + B * Alpha;
         }
-        static FVector lerp(const FVector& A, const FVector& B, const FVector& Alpha) {
-            return A * (1.0 - Alpha) + B * Alpha;
+        static TVector lerp(const TVector& A, const TVector& B, const TVector& Alpha) {
+            return A * (T(1) - Alpha) + B * Alpha;
+        }
+
+        friend TVector operator*(T Scale, const TVector& V)
+        {
+            return V.operator*(Scale);
+        }
+        friend TVector operator-(T Scale, const TVector& V)
+        {
+            return TVector(Scale) - V;
         }
     };
 
-    FVector operator*(double Scale, const FVector& V);
-    FVector operator-(double Scale, const FVector& V);
+    template<typename T>
+    struct TRotator : public glm::vec<3, T> {
+        using glm::vec<3, T>::x;
+        using glm::vec<3, T>::y;
+        using glm::vec<3, T>::z;
 
-    struct FQuat;
-    struct FRotator : public glm::dvec3 {
         // pitch yaw roll == y z x
-        FRotator():FRotator(0, 0, 0){}
-        FRotator(double InPitch, double InYaw, double InRoll ) : glm::dvec3(InPitch, InYaw, InRoll) {}
-        explicit FRotator(const FQuat& q);
-        FQuat Quaternion();
+        TRotator():TRotator(0, 0, 0){}
+        TRotator(T InPitch, T InYaw, T InRoll ) : glm::vec<3, T>(InPitch, InYaw, InRoll) {}
+        explicit TRotator(const TQuat<T>& q);
+        TQuat<T> Quaternion() const;
 
-        static const FRotator ZeroRotator;
+        static const TRotator ZeroRotator;
     };
 
     // glm::quat store wxyz 
-    // FQuat store xyzw
-    struct FQuat : public glm::dquat {
+    // TQuat<T> store xyzw
+    template<typename T>
+    struct TQuat : public glm::qua<T> {
+        using glm::qua<T>::x;
+        using glm::qua<T>::y;
+        using glm::qua<T>::z;
+        using glm::qua<T>::w;
+
         // glm:  w, x, y, z
         // q.xyz = axis.xyz * sin(angle / 2f);
         // q.w = cos(angle / 2f);
@@ -189,76 +215,76 @@ namespace SoulIK
         // glm::quat q = glm::quat(glm::vec3(pitch, yaw, roll));
         // glm::quat q = glm::angleAxis( glm::radians(45.f), glm::vec3( 0.707f, 0.707f, 0. ) );
         // 
-        // FQuat: x, y, z, w
+        // TQuat: x, y, z, w
         // fq.xyz = axis.xyz * sin(angle / 2f);
         // fq.w = cos(angle / 2f);
-        // FQuat q(q2.x, q2.y, q2.z, q2.w);
-        FQuat(glm::dquat q) : FQuat(q.x, q.y, q.z, q.w){}
-        FQuat() : FQuat(0, 0, 0, 1){}
-        FQuat(double _x, double _y, double _z, double _w) : glm::dquat(_w, _x, _y, _z) {}
-        explicit FQuat(const FRotator& rotator) {
-            glm::dquat q = glm::dquat(glm::dvec3(rotator.x, rotator.y, rotator.z));
+        // TQuat q(q2.x, q2.y, q2.z, q2.w);
+        TQuat(glm::qua<T> q) : TQuat(q.x, q.y, q.z, q.w){}
+        TQuat() : TQuat(0, 0, 0, 1){}
+        TQuat(T _x, T _y, T _z, T _w) : glm::qua<T>(_w, _x, _y, _z) {}
+        explicit TQuat(const TRotator<T>& rotator) {
+            glm::qua<T> q = glm::qua<T>(glm::vec<3, T>(rotator.x, rotator.y, rotator.z));
             w = q.w;
             x = q.x;
             y = q.y;
             z = q.z;
         }
-        FQuat(const FQuat& other) {
+        TQuat(const TQuat& other) {
             w = other.w;
             x = other.x;
             y = other.y;
             z = other.z;
         }
 
-        static const FQuat Identity;
-        FRotator Rotator() const
+        static const TQuat Identity;
+        TRotator<T> Rotator() const
 	    {
-            glm::dquat q2(w, x, y, z);  // w,x,y,z
-            glm::dvec3 euler = glm::eulerAngles(q2);
-            return FRotator(euler.x, euler.y, euler.z);
+            glm::qua<T> q2(w, x, y, z);  // w,x,y,z
+            glm::vec<3, T> euler = glm::eulerAngles(q2);
+            return TRotator<T>(euler.x, euler.y, euler.z);
 	    }
-        double Angle() const {
-            return glm::angle(glm::dquat(w, x, y, z));
+        T Angle() const {
+            return glm::angle(glm::qua<T>(w, x, y, z));
         }
-        double AngleDegree() const {
-            return glm::angle(glm::dquat(w, x, y, z)) * 180.0 / glm::pi<double>();
+        T AngleDegree() const {
+            return glm::angle(glm::qua<T>(w, x, y, z)) * 180.0 / glm::pi<T>();
         }
-        FQuat Inverse() const {
-            return FQuat(-x, -y, -z, w);
+        TQuat Inverse() const {
+            return TQuat(-x, -y, -z, w);
         }
         bool IsNormalized() const {
             return (std::abs(1.f - SizeSquared()) < UE_THRESH_QUAT_NORMALIZED);
         }
-        double Size() const
+        T Size() const
         {
             return std::sqrt(x * x + y * y + z * z + w * w);
         }
-        double SizeSquared() const
+        T SizeSquared() const
         {
 	        return (x * x + y * y + z * z + w * w);
         }
-        double getAngle() const
+        T getAngle() const
         {
             return std::acos(w) * 2.0 ;
         }
-        double getAngleDegree() const
+        T getAngleDegree() const
         {
             return std::acos(w) * 2.0 * 180.0 / 3.1415926;
         }
 
-        FQuat GetNormalized(double Tolerance = UE_SMALL_NUMBER) const
+        TQuat GetNormalized(T Tolerance = UE_SMALL_NUMBER) const
         {
-            FQuat Result(*this);
+            TQuat Result(*this);
             Result.Normalize(Tolerance);
             return Result;
         }
-        void Normalize(double Tolerance = UE_SMALL_NUMBER)
+        void Normalize(T Tolerance = UE_SMALL_NUMBER)
         {
-            const double SquareSum = x * x + y * y + z * z + w * w;
+            const T SquareSum = x * x + y * y + z * z + w * w;
 
             if (SquareSum >= Tolerance)
             {
-                const double Scale = 1.0 / std::sqrt(SquareSum);
+                const T Scale = 1.0 / std::sqrt(SquareSum);
 
                 x *= Scale; 
                 y *= Scale; 
@@ -271,7 +297,7 @@ namespace SoulIK
             }
         }
 
-        FVector RotateVector(FVector V) const
+        TVector<T> RotateVector(TVector<T> V) const
         {	
             // http://people.csail.mit.edu/bkph/articles/Quaternions.pdf
             // V' = V + 2w(Q x V) + (2Q x (Q x V))
@@ -280,38 +306,38 @@ namespace SoulIK
             // T = 2(Q x V);
             // V' = V + w*(T) + (Q x T)
 
-            const FVector Q(x, y, z);
-            const FVector TT = 2.f * FVector::CrossProduct(Q, V);
-            const FVector Result = V + (w * TT) + FVector::CrossProduct(Q, TT);
+            const TVector<T> Q(x, y, z);
+            const TVector<T> TT = 2.f * TVector<T>::CrossProduct(Q, V);
+            const TVector<T> Result = V + (w * TT) + TVector<T>::CrossProduct(Q, TT);
             return Result;
-            // glm::dquat q(w, x, y, z);
-            // glm::dvec3 v(V.x, V.y, V.z);
+            // glm::qua<T> q(w, x, y, z);
+            // glm::vec<3, T> v(V.x, V.y, V.z);
             // v = glm::rotate(q, v);
-            // return FVector(v);
+            // return TVector<T>(v);
         }
 
-        double operator|(const FQuat& Q) const
+        T operator|(const TQuat& Q) const
         {
             return x * Q.x + y * Q.y + z * Q.z + w * Q.w;
         }
 
         // https://en.wikipedia.org/wiki/Quaternion#Hamilton_product
-        void VectorQuaternionMultiply(FQuat* Result, const FQuat* Quat1, const FQuat* Quat2) const {
-            typedef double Double4[4];
-            const Double4& A = *((const Double4*)Quat1);
-            const Double4& B = *((const Double4*)Quat2);
-            Double4& R = *((Double4*)Result);
+        void VectorQuaternionMultiply(TQuat* Result, const TQuat* Quat1, const TQuat* Quat2) const {
+            typedef T Real4[4];
+            const Real4& A = *((const Real4*)Quat1);
+            const Real4& B = *((const Real4*)Quat2);
+            Real4& R = *((Real4*)Result);
         #if USE_FAST_QUAT_MUL  // 27+ 8*
-            const double T0 = (A[3] - A[2]) * (B[2] - B[3]);
-            const double T1 = (A[0] + A[1]) * (B[0] + B[1]);
-            const double T2 = (A[0] - A[1]) * (B[2] + B[3]);
-            const double T3 = (A[2] + A[3]) * (B[0] - B[1]);
-            const double T4 = (A[3] - A[1]) * (B[1] - B[2]);
-            const double T5 = (A[3] + A[1]) * (B[1] + B[2]);
-            const double T6 = (A[0] + A[2]) * (B[0] - B[3]);
-            const double T7 = (A[0] - A[2]) * (B[0] + B[3]);
-            const double T8 = T5 + T6 + T7;
-            const double T9 = 0.5 * (T4 + T8);
+            const T T0 = (A[3] - A[2]) * (B[2] - B[3]);
+            const T T1 = (A[0] + A[1]) * (B[0] + B[1]);
+            const T T2 = (A[0] - A[1]) * (B[2] + B[3]);
+            const T T3 = (A[2] + A[3]) * (B[0] - B[1]);
+            const T T4 = (A[3] - A[1]) * (B[1] - B[2]);
+            const T T5 = (A[3] + A[1]) * (B[1] + B[2]);
+            const T T6 = (A[0] + A[2]) * (B[0] - B[3]);
+            const T T7 = (A[0] - A[2]) * (B[0] + B[3]);
+            const T T8 = T5 + T6 + T7;
+            const T T9 = 0.5 * (T4 + T8);
 
             R[1] = T1 + T9 - T8;
             R[2] = T2 + T9 - T7;
@@ -319,10 +345,10 @@ namespace SoulIK
             R[0] = T0 + T9 - T5;
         #else  // 12+  16*
             // store intermediate results in temporaries
-            const double TX = A[0] * B[1] + A[1] * B[0] + A[2] * B[3] - A[3] * B[2];
-            const double TY = A[0] * B[2] - A[1] * B[3] + A[2] * B[0] + A[3] * B[1];
-            const double TZ = A[0] * B[3] + A[1] * B[2] - A[2] * B[1] + A[3] * B[0];
-            const double TW = A[0] * B[0] - A[1] * B[1] - A[2] * B[2] - A[3] * B[3];
+            const T TX = A[0] * B[1] + A[1] * B[0] + A[2] * B[3] - A[3] * B[2];
+            const T TY = A[0] * B[2] - A[1] * B[3] + A[2] * B[0] + A[3] * B[1];
+            const T TZ = A[0] * B[3] + A[1] * B[2] - A[2] * B[1] + A[3] * B[0];
+            const T TW = A[0] * B[0] - A[1] * B[1] - A[2] * B[2] - A[3] * B[3];
 
             // copy intermediate result to *this
             R[1] = TX;
@@ -333,28 +359,28 @@ namespace SoulIK
         }
 
         #if 0
-        void VectorQuaternionMultiply(FQuat* Result, const FQuat* Quat1, const FQuat* Quat2) const {
+        void VectorQuaternionMultiply(TQuat* Result, const TQuat* Quat1, const TQuat* Quat2) const {
             // input wxyz, but need store:  xyzw
-            typedef double Double4[4];
-            const double A[4] =  {Quat1->x, Quat1->y, Quat1->z, Quat1->w};
-            const double B[4] =  {Quat2->x, Quat2->y, Quat2->z, Quat2->w};
-            double R[4] =  {Quat2->x, Quat2->y, Quat2->z, Quat2->w};
+            typedef T Real4[4];
+            const T A[4] =  {Quat1->x, Quat1->y, Quat1->z, Quat1->w};
+            const T B[4] =  {Quat2->x, Quat2->y, Quat2->z, Quat2->w};
+            T R[4] =  {Quat2->x, Quat2->y, Quat2->z, Quat2->w};
             
-            //const Double4& A = *((const Double4*)Quat1);
-            //const Double4& B = *((const Double4*)Quat2);
-            //Double4& R = *((Double4*)Result);
+            //const Real4& A = *((const Real4*)Quat1);
+            //const Real4& B = *((const Real4*)Quat2);
+            //Real4& R = *((Real4*)Result);
         #define USE_FAST_QUAT_MUL 1
         #if USE_FAST_QUAT_MUL
-            const double T0 = (A[2] - A[1]) * (B[1] - B[2]);
-            const double T1 = (A[3] + A[0]) * (B[3] + B[0]);
-            const double T2 = (A[3] - A[0]) * (B[1] + B[2]);
-            const double T3 = (A[1] + A[2]) * (B[3] - B[0]);
-            const double T4 = (A[2] - A[0]) * (B[0] - B[1]);
-            const double T5 = (A[2] + A[0]) * (B[0] + B[1]);
-            const double T6 = (A[3] + A[1]) * (B[3] - B[2]);
-            const double T7 = (A[3] - A[1]) * (B[3] + B[2]);
-            const double T8 = T5 + T6 + T7;
-            const double T9 = 0.5 * (T4 + T8);
+            const T T0 = (A[2] - A[1]) * (B[1] - B[2]);
+            const T T1 = (A[3] + A[0]) * (B[3] + B[0]);
+            const T T2 = (A[3] - A[0]) * (B[1] + B[2]);
+            const T T3 = (A[1] + A[2]) * (B[3] - B[0]);
+            const T T4 = (A[2] - A[0]) * (B[0] - B[1]);
+            const T T5 = (A[2] + A[0]) * (B[0] + B[1]);
+            const T T6 = (A[3] + A[1]) * (B[3] - B[2]);
+            const T T7 = (A[3] - A[1]) * (B[3] + B[2]);
+            const T T8 = T5 + T6 + T7;
+            const T T9 = 0.5 * (T4 + T8);
 
             R[0] = T1 + T9 - T8;
             R[1] = T2 + T9 - T7;
@@ -362,10 +388,10 @@ namespace SoulIK
             R[3] = T0 + T9 - T5;
         #else
             // store intermediate results in temporaries
-            const double TX = A[3] * B[0] + A[0] * B[3] + A[1] * B[2] - A[2] * B[1];
-            const double TY = A[3] * B[1] - A[0] * B[2] + A[1] * B[3] + A[2] * B[0];
-            const double TZ = A[3] * B[2] + A[0] * B[1] - A[1] * B[0] + A[2] * B[3];
-            const double TW = A[3] * B[3] - A[0] * B[0] - A[1] * B[1] - A[2] * B[2];
+            const T TX = A[3] * B[0] + A[0] * B[3] + A[1] * B[2] - A[2] * B[1];
+            const T TY = A[3] * B[1] - A[0] * B[2] + A[1] * B[3] + A[2] * B[0];
+            const T TZ = A[3] * B[2] + A[0] * B[1] - A[1] * B[0] + A[2] * B[3];
+            const T TW = A[3] * B[3] - A[0] * B[0] - A[1] * B[1] - A[2] * B[2];
 
             // copy intermediate result to *this
             R[0] = TX;
@@ -382,28 +408,45 @@ namespace SoulIK
         #endif
 
         #ifndef QUAT_GLM_ADAPTER  // use parent multiply
-        FQuat operator*(const FQuat& Q) const {
-	        FQuat Result;
+        TQuat operator*(const TQuat& Q) const {
+	        TQuat Result;
             VectorQuaternionMultiply(&Result, this, &Q);
             return Result;
         }
         #endif
         
-        static double FloatSelect(const double Comparand, const double ValueGEZero, const double ValueLTZero )
+        static T FloatSelect(const T Comparand, const T ValueGEZero, const T ValueLTZero )
         {
             return Comparand >= 0.f ? ValueGEZero : ValueLTZero;
         }
 
         // https://en.wikipedia.org/wiki/Slerp
-        static FQuat FastLerp(const FQuat& A, const FQuat& B, const double Alpha)
+        static TQuat FastLerp(const TQuat& A, const TQuat& B, const T Alpha)
         {
             // To ensure the 'shortest route', we make sure the dot product between the both rotations is positive.
-            const double DotResult = (A | B);
-            const double Bias = FloatSelect(DotResult, double(1.0f), double(-1.0f));
+            const T DotResult = (A | B);
+            const T Bias = FloatSelect(DotResult, T(1.0f), T(-1.0f));
             return (B * Alpha) + (A * (Bias * (1.f - Alpha)));
         }
     };
 
+    template<typename T>
+    TRotator<T>::TRotator(const TQuat<T>& q)
+    {
+        glm::qua<T> q2(q.w, q.x, q.y, q.z);  // w,x,y,z
+        glm::vec<3, T> euler = glm::eulerAngles(q2);
+        x = euler.x;
+        y = euler.y;
+        z = euler.z;
+    }
+
+    template<typename T>
+    TQuat<T> TRotator<T>::Quaternion() const
+    {
+        glm::qua<T> q = glm::qua<T>(glm::vec<3, T>(x, y, z));
+        return TQuat<T>(q.x, q.y, q.z, q.w);
+    }
+
     struct FMatrix4 : glm::dmat4 {
 
         // glm: col vector, col major
@@ -419,123 +462,111 @@ namespace SoulIK
     };
 
     //  TODO: use cast instead of construct new
-    struct FTransform
+    template<typename T>
+    struct TTransform
     {
         // Rotation of this transformation, as a quaternion.
-        FQuat   Rotation;
+        TQuat<T>   Rotation;
 	    // Translation of this transformation, as a vector.
-	    FVector Translation;
+	    TVector<T> Translation;
 	    // 3D scale (always applied in local space) as a vector.
-	    FVector  Scale3D;
+	    TVector<T>  Scale3D;
 
-        static const FTransform Identity;
+        static const TTransform Identity;
 
-        FTransform()
+        TTransform()
 		: Rotation(0.f, 0.f, 0.f, 1.f)
 		, Translation(0.f)
-		, Scale3D(FVector::OneVector)
+		, Scale3D(TVector<T>::OneVector)
 	    {
 	    }
 
-        explicit FTransform(const FVector& InTranslation)
-		: Rotation(FQuat::Identity),
+        explicit TTransform(const TVector<T>& InTranslation)
+		: Rotation(TQuat<T>::Identity),
 		Translation(InTranslation),
-		Scale3D(FVector::OneVector) 
+		Scale3D(TVector<T>::OneVector) 
         {
         }
 
-        explicit FTransform(const FQuat& InRotation)
+        explicit TTransform(const TQuat<T>& InRotation)
 		: Rotation(InRotation),
-		Translation(FVector::ZeroVector),
-		Scale3D(FVector::OneVector)
+		Translation(TVector<T>::ZeroVector),
+		Scale3D(TVector<T>::OneVector)
 	    {
         }
 
-        explicit FTransform(const FRotator& InRotation)
+        explicit TTransform(const TRotator<T>& InRotation)
 		: Rotation(InRotation),
-		Translation(FVector::ZeroVector),
-		Scale3D(FVector::OneVector)
+		Translation(TVector<T>::ZeroVector),
+		Scale3D(TVector<T>::OneVector)
 	    {
         }
 
-        FTransform(const FQuat& InRotation, const FVector& InTranslation, const FVector& InScale3D = FVector::OneVector)
+        TTransform(const TQuat<T>& InRotation, const TVector<T>& InTranslation, const TVector<T>& InScale3D = TVector<T>::OneVector)
 		: Rotation(InRotation),
 		Translation(InTranslation),
 		Scale3D(InScale3D)
 	    {
         }
 
-        FTransform(const FRotator& InRotation, const FVector& InTranslation, const FVector& InScale3D = FVector::OneVector)
+        TTransform(const TRotator<T>& InRotation, const TVector<T>& InTranslation, const TVector<T>& InScale3D = TVector<T>::OneVector)
 		: Rotation(InRotation),
 		Translation(InTranslation),
 		Scale3D(InScale3D)
 	    {
         }
-        explicit FTransform(const glm::mat4 InMatrix)
-	    {
-		    SetFromMatrix(InMatrix);
-        }
-        explicit FTransform(const glm::dmat4 InMatrix)
+        // from glm matrix of any precision (glm::mat4 / glm::dmat4)
+        template<typename U>
+        explicit TTransform(const glm::mat<4, 4, U>& InMatrix)
 	    {
 		    SetFromMatrix(InMatrix);
         }
 
         // Constructor that takes basis axes and translation
-	    FTransform(const FVector& InX, const FVector& InY, const FVector& InZ, const FVector& InTranslation)
+	    TTransform(const TVector<T>& InX, const TVector<T>& InY, const TVector<T>& InZ, const TVector<T>& InTranslation)
 	    {
-            glm::dvec4 X(InX.x, InX.y, InX.z, 0);
-            glm::dvec4 Y(InY.x, InY.y, InY.z, 0);
-            glm::dvec4 Z(InZ.x, InZ.y, InZ.z, 0);
-            glm::dvec4 T(InTranslation.x, InTranslation.y, InTranslation.z, 1);
-            glm::dmat4 m(X, Y, Z, T);
+            glm::vec<4, T> X(InX.x, InX.y, InX.z, 0);
+            glm::vec<4, T> Y(InY.x, InY.y, InY.z, 0);
+            glm::vec<4, T> Z(InZ.x, InZ.y, InZ.z, 0);
+            glm::vec<4, T> W(InTranslation.x, InTranslation.y, InTranslation.z, 1);
+            glm::mat<4, 4, T> m(X, Y, Z, W);
 
 		    SetFromMatrix(m);
 	    }
 
-        void SetFromMatrix(const glm::dmat4& m) {
-            glm::dvec3 scale;
-            glm::dvec3 translation;
-            glm::dvec3 skew;
-            glm::dvec4 perspective;
-            glm::dquat q;
-
-            glm::decompose(m, scale, q, translation, skew, perspective);
-            Rotation = FQuat(q.x, q.y, q.z, q.w);
-            Scale3D = FVector(scale.x, scale.y, scale.z);
-            Translation = FVector(translation.x, translation.y, translation.z);
-        }
-        void SetFromMatrix(const glm::mat4& m) {
-            glm::vec3 scale;
-            glm::vec3 translation;
-            glm::vec3 skew;
-            glm::vec4 perspective;
-            glm::quat q;
+        template<typename U>
+        void SetFromMatrix(const glm::mat<4, 4, U>& m) {
+            glm::vec<3, U> scale;
+            glm::vec<3, U> translation;
+            glm::vec<3, U> skew;
+            glm::vec<4, U> perspective;
+            glm::qua<U> q;
 
             glm::decompose(m, scale, q, translation, skew, perspective);
-            Rotation = FQuat(q.x, q.y, q.z, q.w);
-            Scale3D = FVector(scale.x, scale.y, scale.z);
-            Translation = FVector(translation.x, translation.y, translation.z);
+            Rotation = TQuat<T>(q.x, q.y, q.z, q.w);
+            Scale3D = TVector<T>(scale.x, scale.y, scale.z);
+            Translation = TVector<T>(translation.x, translation.y, translation.z);
         }
         
-        FTransform Inverse() const
+        TTransform Inverse() const
         {
-            FQuat   InvRotation = Rotation.Inverse();
-            FVector InvScale3D = GetSafeScaleReciprocal(Scale3D);
+            TQuat<T>   InvRotation = Rotation.Inverse();
+            TVector<T> InvScale3D = GetSafeScaleReciprocal(Scale3D);
 
-            glm::dquat invq(InvRotation.w, InvRotation.x, InvRotation.y, InvRotation.z);
-            glm::dvec3 invs(InvScale3D.x, InvScale3D.y, InvScale3D.z);
-            glm::dvec3 t(Translation.x, Translation.y, Translation.z);
-            glm::dvec3 invt = invq * (invs * (-t));
+            glm::qua<T> invq(InvRotation.w, InvRotation.x, InvRotation.y, InvRotation.z);
+            glm::vec<3, T> invs(InvScale3D.x, InvScale3D.y, InvScale3D.z);
+            glm::vec<3, T> t(Translation.x, Translation.y, Translation.z);
+            glm::vec<3, T> invt = invq * (invs * (-t));
 
-            return FTransform(FQuat(invq), FVector(invt), FVector(invs));
+            return TTransform(TQuat<T>(invq), TVector<T>(invt), TVector<T>(invs));
         }
 
-        FTransform operator*(double Mult) const
+        TTransform operator*(T Mult) const
         {
-            return FTransform(Rotation * Mult, Translation * Mult, Scale3D * Mult);
+            return TTransform(Rotation * Mult, Translation * Mult, Scale3D * Mult);
         }
 
-        FTransform& operator*=(double Mult)
+        TTransform& operator*=(T Mult)
         {
             Translation *= Mult;
             Rotation.x *= Mult;
@@ -547,14 +578,14 @@ namespace SoulIK
             return *this;
         }
 
-        void Multiply(FTransform* OutTransform, const FTransform* A, const FTransform* B) const
+        void Multiply(TTransform* OutTransform, const TTransform* A, const TTransform* B) const
         {
             // TODO: adapter
             #if 0 //#ifdef FTRANSFORM_GLM_ADAPTER
-            glm::dmat4 ma = A->ToMatrixWithScale();
-            glm::dmat4 mb = B->ToMatrixWithScale();
-            glm::dmat4 mc = mb * ma;
-            *OutTransform = FTransform(mc);
+            glm::mat<4, 4, T> ma = A->ToMatrixWithScale();
+            glm::mat<4, 4, T> mb = B->ToMatrixWithScale();
+            glm::mat<4, 4, T> mc = mb * ma;
+            *OutTransform = TTransform(mc);
 
             if(AnyHasNegativeScale(A->Scale3D, OutTransform->Scale3D)) {
                 printf("error\n");
@@ -593,17 +624,17 @@ namespace SoulIK
             // that was removed at rev 21 with UE4
             #endif
         }
-        FTransform GetRelativeTransform(const FTransform& Other) const {
+        TTransform GetRelativeTransform(const TTransform& Other) const {
 
             // TODO: adapter
             #if 0 // #ifdef FTRANSFORM_GLM_ADAPTER
-            glm::dmat4 m1 = this->ToMatrixWithScale();
-            glm::dmat4 m2 = Other.Inverse().ToMatrixWithScale();
+            glm::mat<4, 4, T> m1 = this->ToMatrixWithScale();
+            glm::mat<4, 4, T> m2 = Other.Inverse().ToMatrixWithScale();
             // glm: gchild = gparent * lchild  => lchild =  gparent.inv * gchild
             // ftransform: gchild = lchild * gparent => lchild = gchild * gparent.inv
             // => glm impl:  lchild = gparent.inv * gchild
-            glm::dmat4 m3 = m2 * m1;
-            FTransform Result = FTransform(m3);
+            glm::mat<4, 4, T> m3 = m2 * m1;
+            TTransform Result = TTransform(m3);
             return Result;
 
             #else
@@ -614,25 +645,20 @@ namespace SoulIK
             // Rotation = Q(B)(-1) * Q(A)
             // Translation = 1/S(B) *[Q(B)(-1)*(T(A)-T(B))*Q(B)]
             // where A = this, B = Other
-            FTransform Result;
+            TTransform Result;
 
             if (AnyHasNegativeScale(Scale3D, Other.GetScale3D()))
             {
                 // @note, if you have 0 scale with negative, you're going to lose rotation as it can't convert back to quat
                 GetRelativeTransformUsingMatrixWithScale(&Result, this, &Other);
-                printf("AnyHasNegativeScale\n");
             }
             else
             {
-                FVector SafeRecipScale3D = GetSafeScaleReciprocal(Other.Scale3D, UE_SMALL_NUMBER);
+                // Other.Rotation is expected normalized, checked per pose by SoulPoseValidation.h
+                TVector<T> SafeRecipScale3D = GetSafeScaleReciprocal(Other.Scale3D, UE_SMALL_NUMBER);
                 Result.Scale3D = Scale3D*SafeRecipScale3D;
 
-                if (Other.Rotation.IsNormalized() == false)
-                {
-                    return FTransform::Identity;
-                }
-
-                FQuat Inverse = Other.Rotation.Inverse();
+                TQuat<T> Inverse = Other.Rotation.Inverse();
                 Result.Rotation = Inverse*Rotation;
 
                 Result.Translation = (Inverse*(Translation - Other.Translation))*(SafeRecipScale3D);
@@ -642,28 +668,28 @@ namespace SoulIK
             #endif
         }
 
-        FTransform operator*(const FTransform& Other) const
+        TTransform operator*(const TTransform& Other) const
         {
-            FTransform Output;
+            TTransform Output;
             Multiply(&Output, this, &Other);
             return Output;
         }
-        void operator*=(const FTransform& Other)
+        void operator*=(const TTransform& Other)
         {
 	        Multiply(this, this, &Other);
         }
-        FTransform operator/(const FTransform& Other) const
+        TTransform operator/(const TTransform& Other) const
         {
-            FTransform Output;
+            TTransform Output;
             Output = GetRelativeTransform(Other);
             return Output;
         }
-        //FTransform operator*(const FQuat& Other) const;
-        //void operator*=(const FQuat& Other);
+        //TTransform operator*(const TQuat<T>& Other) const;
+        //void operator*=(const TQuat<T>& Other);
 
-        FVector GetSafeScaleReciprocal(const FVector& InScale, double Tolerance = ZeroTolerance) const
+        TVector<T> GetSafeScaleReciprocal(const TVector<T>& InScale, T Tolerance = ZeroTolerance) const
         {
-            FVector SafeReciprocalScale;
+            TVector<T> SafeReciprocalScale;
             if (std::abs(InScale.x) <= Tolerance)
             {
                 SafeReciprocalScale.x = 0.f;
@@ -694,94 +720,94 @@ namespace SoulIK
             return SafeReciprocalScale;
         }
 
-        void AddToTranslation(const FVector& DeltaTranslation)
+        void AddToTranslation(const TVector<T>& DeltaTranslation)
         {
             Translation += DeltaTranslation;
         
         }
 
-        FQuat GetRotation() const
+        TQuat<T> GetRotation() const
         {
             return Rotation;
         }
-        void SetRotation(const FQuat& NewRotation)
+        void SetRotation(const TQuat<T>& NewRotation)
         {
             Rotation = NewRotation;
         }
-        FVector GetTranslation() const
+        TVector<T> GetTranslation() const
         {
             return Translation;
         }
-        void SetTranslation(const FVector& NewTranslation)
+        void SetTranslation(const TVector<T>& NewTranslation)
 	    {
 		    Translation = NewTranslation;
 	    }
-        FVector GetScale3D() const
+        TVector<T> GetScale3D() const
         {
             return Scale3D;
         }
-        void SetScale3D(const FVector& NewScale3D)
+        void SetScale3D(const TVector<T>& NewScale3D)
         {
             Scale3D = NewScale3D;
         }
         
         
-        bool AnyHasNegativeScale(const FVector& InScale3D, const  FVector& InOtherScale3D) const
+        bool AnyHasNegativeScale(const TVector<T>& InScale3D, const  TVector<T>& InOtherScale3D) const
         {
             return  (InScale3D.x < 0.f || InScale3D.y < 0.f || InScale3D.z < 0.f 
             || InOtherScale3D.x < 0.f || InOtherScale3D.y < 0.f || InOtherScale3D.z < 0.f );
         }
 
         // Convert this Transform to a transformation matrix, ignoring its scaling
-        glm::dmat4 ToMatrixNoScale() const
+        glm::mat<4, 4, T> ToMatrixNoScale() const
         {
             #if 0  //FTRANSFORM_GLM_ADAPTER
             // TODO: adapter, should have better approach
-            glm::dquat q(Rotation.w, Rotation.x, Rotation.y, Rotation.z);
-            glm::dvec3 t(Translation.x, Translation.y, Translation.z);
+            glm::qua<T> q(Rotation.w, Rotation.x, Rotation.y, Rotation.z);
+            glm::vec<3, T> t(Translation.x, Translation.y, Translation.z);
 
-            glm::dmat4 identity(1.0);
-            glm::dmat4 mt = glm::translate(identity, t);
-            glm::dmat4 mr = glm::mat4_cast(q);
-            glm::dmat4 OutMatrix = mt * mr;
+            glm::mat<4, 4, T> identity(1.0);
+            glm::mat<4, 4, T> mt = glm::translate(identity, t);
+            glm::mat<4, 4, T> mr = glm::mat4_cast(q);
+            glm::mat<4, 4, T> OutMatrix = mt * mr;
             return OutMatrix;
             
             #else
-            glm::dmat4 OutMatrix;
+            glm::mat<4, 4, T> OutMatrix;
 
             OutMatrix[3][0] = Translation.x;
             OutMatrix[3][1] = Translation.y;
             OutMatrix[3][2] = Translation.z;
 
-            const double x2 = Rotation.x + Rotation.x;
-            const double y2 = Rotation.y + Rotation.y;
-            const double z2 = Rotation.z + Rotation.z;
+            const T x2 = Rotation.x + Rotation.x;
+            const T y2 = Rotation.y + Rotation.y;
+            const T z2 = Rotation.z + Rotation.z;
             {
-                const double xx2 = Rotation.x * x2;
-                const double yy2 = Rotation.y * y2;
-                const double zz2 = Rotation.z * z2;
+                const T xx2 = Rotation.x * x2;
+                const T yy2 = Rotation.y * y2;
+                const T zz2 = Rotation.z * z2;
 
                 OutMatrix[0][0] = (1.0f - (yy2 + zz2));
                 OutMatrix[1][1] = (1.0f - (xx2 + zz2));
                 OutMatrix[2][2] = (1.0f - (xx2 + yy2));
             }
             {
-                const double yz2 = Rotation.y * z2;
-                const double wx2 = Rotation.w * x2;
+                const T yz2 = Rotation.y * z2;
+                const T wx2 = Rotation.w * x2;
 
                 OutMatrix[2][1] = (yz2 - wx2);
                 OutMatrix[1][2] = (yz2 + wx2);
             }
             {
-                const double xy2 = Rotation.x * y2;
-                const double wz2 = Rotation.w * z2;
+                const T xy2 = Rotation.x * y2;
+                const T wz2 = Rotation.w * z2;
 
                 OutMatrix[1][0] = (xy2 - wz2);
                 OutMatrix[0][1] = (xy2 + wz2);
             }
             {
-                const double xz2 = Rotation.x * z2;
-                const double wy2 = Rotation.w * y2;
+                const T xz2 = Rotation.x * z2;
+                const T wy2 = Rotation.w * y2;
 
                 OutMatrix[2][0] = (xz2 + wy2);
                 OutMatrix[0][2] = (xz2 - wy2);
@@ -797,61 +823,61 @@ namespace SoulIK
         }
 
         // Convert this Transform to a transformation matrix, with its scaling
-        glm::dmat4 ToMatrixWithScale() const
+        glm::mat<4, 4, T> ToMatrixWithScale() const
         {
             #if 0  // FTRANSFORM_GLM_ADAPTER
             // col representation, col major
 
             // TODO: adapter, should have better approach
-            glm::dquat q(Rotation.w, Rotation.x, Rotation.y, Rotation.z);
-            glm::dvec3 t(Translation.x, Translation.y, Translation.z);
-            glm::dvec3 s(Scale3D.x, Scale3D.y, Scale3D.z);
-
-            glm::dmat4 identity(1.0);
-            glm::dmat4 mt = glm::translate(identity, t);
-            glm::dmat4 ms = glm::scale(identity, s);
-            glm::dmat4 mr = glm::mat4_cast(q);
-            glm::dmat4 OutMatrix = mt * mr * ms;
+            glm::qua<T> q(Rotation.w, Rotation.x, Rotation.y, Rotation.z);
+            glm::vec<3, T> t(Translation.x, Translation.y, Translation.z);
+            glm::vec<3, T> s(Scale3D.x, Scale3D.y, Scale3D.z);
+
+            glm::mat<4, 4, T> identity(1.0);
+            glm::mat<4, 4, T> mt = glm::translate(identity, t);
+            glm::mat<4, 4, T> ms = glm::scale(identity, s);
+            glm::mat<4, 4, T> mr = glm::mat4_cast(q);
+            glm::mat<4, 4, T> OutMatrix = mt * mr * ms;
             return OutMatrix;
 
             #else 
 
-            glm::dmat4 OutMatrix;
+            glm::mat<4, 4, T> OutMatrix;
 
             // row representation, row major
             OutMatrix[3][0] = Translation.x;
             OutMatrix[3][1] = Translation.y;
             OutMatrix[3][2] = Translation.z;
 
-            const double x2 = Rotation.x + Rotation.x;
-            const double y2 = Rotation.y + Rotation.y;
-            const double z2 = Rotation.z + Rotation.z;
+            const T x2 = Rotation.x + Rotation.x;
+            const T y2 = Rotation.y + Rotation.y;
+            const T z2 = Rotation.z + Rotation.z;
             {
-                const double xx2 = Rotation.x * x2;
-                const double yy2 = Rotation.y * y2;
-                const double zz2 = Rotation.z * z2;
+                const T xx2 = Rotation.x * x2;
+                const T yy2 = Rotation.y * y2;
+                const T zz2 = Rotation.z * z2;
 
                 OutMatrix[0][0] = (1.0f - (yy2 + zz2)) * Scale3D.x;
                 OutMatrix[1][1] = (1.0f - (xx2 + zz2)) * Scale3D.y;
                 OutMatrix[2][2] = (1.0f - (xx2 + yy2)) * Scale3D.z;
             }
             {
-                const double yz2 = Rotation.y * z2;
-                const double wx2 = Rotation.w * x2;
+                const T yz2 = Rotation.y * z2;
+                const T wx2 = Rotation.w * x2;
 
                 OutMatrix[2][1] = (yz2 - wx2) * Scale3D.z;
                 OutMatrix[1][2] = (yz2 + wx2) * Scale3D.y;
             }
             {
-                const double xy2 = Rotation.x * y2;
-                const double wz2 = Rotation.w * z2;
+                const T xy2 = Rotation.x * y2;
+                const T wz2 = Rotation.w * z2;
 
                 OutMatrix[1][0] = (xy2 - wz2) * Scale3D.y;
                 OutMatrix[0][1] = (xy2 + wz2) * Scale3D.x;
             }
             {
-                const double xz2 = Rotation.x * z2;
-                const double wy2 = Rotation.w * y2;
+                const T xz2 = Rotation.x * z2;
+                const T wy2 = Rotation.w * y2;
 
                 OutMatrix[2][0] = (xz2 + wy2) * Scale3D.z;
                 OutMatrix[0][2] = (xz2 - wy2) * Scale3D.x;
@@ -866,62 +892,58 @@ namespace SoulIK
             #endif
         }
 
-        FVector TransformPosition(const FVector& V) const
+        TVector<T> TransformPosition(const TVector<T>& V) const
         {
-            FVector rv = Rotation.RotateVector(Scale3D * V);
-            double len = Rotation.Size();
-            if (std::abs(len - 1.0) > 0.1) {
-                printf("not normalize\n");
-                assert(false);
-            }
+            // rotation is expected normalized, checked per pose by SoulPoseValidation.h
+            TVector<T> rv = Rotation.RotateVector(Scale3D * V);
             return  rv + Translation;
         }
         
-        void MultiplyUsingMatrixWithScale(FTransform* OutTransform, const FTransform* A, const FTransform* B) const {
-            glm::dmat4 m1 = A->ToMatrixWithScale();
-            glm::dmat4 m2 = B->ToMatrixWithScale();
-            glm::dmat4 m3 = m2 * m1;
-            *OutTransform = FTransform(m3);
+        void MultiplyUsingMatrixWithScale(TTransform* OutTransform, const TTransform* A, const TTransform* B) const {
+            glm::mat<4, 4, T> m1 = A->ToMatrixWithScale();
+            glm::mat<4, 4, T> m2 = B->ToMatrixWithScale();
+            glm::mat<4, 4, T> m3 = m2 * m1;
+            *OutTransform = TTransform(m3);
         }
 
-        void GetRelativeTransformUsingMatrixWithScale(FTransform* OutTransform, const FTransform* Base, const FTransform* Relative) const
+        void GetRelativeTransformUsingMatrixWithScale(TTransform* OutTransform, const TTransform* Base, const TTransform* Relative) const
         {
             #if 1 // #ifdef FTRANSFORM_GLM_ADAPTER
-            glm::dmat4 m1 = Base->ToMatrixWithScale();
-            glm::dmat4 m2 = Relative->Inverse().ToMatrixWithScale();
+            glm::mat<4, 4, T> m1 = Base->ToMatrixWithScale();
+            glm::mat<4, 4, T> m2 = Relative->Inverse().ToMatrixWithScale();
             // glm: gchild = gparent * lchild  => lchild =  gparent.inv * gchild
             // ftransform: gchild = lchild * gparent => lchild = gchild * gparent.inv
             // => glm impl:  lchild = gparent.inv * gchild
-            glm::dmat4 m3 = m2 * m1;
+            glm::mat<4, 4, T> m3 = m2 * m1;
 
             #else
             // the goal of using M is to get the correct orientation
             // but for translation, we still need scale
-            glm::dmat4 AM = Base->ToMatrixWithScale();
-	        glm::dmat4 BM = Relative->ToMatrixWithScale();
+            glm::mat<4, 4, T> AM = Base->ToMatrixWithScale();
+	        glm::mat<4, 4, T> BM = Relative->ToMatrixWithScale();
             // get combined scale
-            FVector SafeRecipScale3D = GetSafeScaleReciprocal(Relative->Scale3D, UE_SMALL_NUMBER);
-            FVector DesiredScale3D = Base->Scale3D*SafeRecipScale3D;
+            TVector<T> SafeRecipScale3D = GetSafeScaleReciprocal(Relative->Scale3D, UE_SMALL_NUMBER);
+            TVector<T> DesiredScale3D = Base->Scale3D*SafeRecipScale3D;
             ConstructTransformFromMatrixWithDesiredScale(AM, glm::inverse(BM), DesiredScale3D, *OutTransform);
             #endif
         }
-        void ConstructTransformFromMatrixWithDesiredScale(const glm::dmat4& AMatrix, const glm::dmat4& BMatrix, const FVector& DesiredScale, FTransform& OutTransform) const
+        void ConstructTransformFromMatrixWithDesiredScale(const glm::mat<4, 4, T>& AMatrix, const glm::mat<4, 4, T>& BMatrix, const TVector<T>& DesiredScale, TTransform& OutTransform) const
         {
             // todo
             #if 1 // #ifdef FTRANSFORM_GLM_ADAPTER
             // glm: gchild = gparent * lchild => lchild = gparent.inv * gchild 
             // => ue: gchild * gparent.inv
-            glm::dmat4 m3 = BMatrix * AMatrix;
-            OutTransform = FTransform(m3);
+            glm::mat<4, 4, T> m3 = BMatrix * AMatrix;
+            OutTransform = TTransform(m3);
 
             #else
             // the goal of using M is to get the correct orientation
             // but for translation, we still need scale
-            glm::dmat4 M = AMatrix * BMatrix;
+            glm::mat<4, 4, T> M = AMatrix * BMatrix;
             M.RemoveScaling();
 
             // apply negative scale back to axes
-            FVector SignedScale = DesiredScale.GetSignVector();
+            TVector<T> SignedScale = DesiredScale.GetSignVector();
 
             M.SetAxis(0, SignedScale.X * M.GetScaledAxis(EAxis::X));
             M.SetAxis(1, SignedScale.Y * M.GetScaledAxis(EAxis::Y));
@@ -929,7 +951,7 @@ namespace SoulIK
 
             // @note: if you have negative with 0 scale, this will return rotation that is identity
             // since matrix loses that axes
-            FQuat Rotation =FQuat(glm::quat_cast(M));
+            TQuat<T> Rotation =TQuat<T>(glm::quat_cast(M));
             Rotation.Normalize();
 
             // set values back to output
@@ -943,4 +965,33 @@ namespace SoulIK
             #endif
         }
     };
-}
\ No newline at end of file
+
+    template<typename T> const TVector<T> TVector<T>::ZeroVector = TVector<T>(0, 0, 0);
+    template<typename T> const TVector<T> TVector<T>::OneVector = TVector<T>(1, 1, 1);
+    template<typename T> const TVector<T> TVector<T>::XAxisVector = TVector<T>(1, 0, 0);
+    template<typename T> const TVector<T> TVector<T>::YAxisVector = TVector<T>(0, 1, 0);
+    template<typename T> const TVector<T> TVector<T>::ZAxisVector = TVector<T>(0, 0, 1);
+    template<typename T> const TRotator<T> TRotator<T>::ZeroRotator = TRotator<T>(0, 0, 0);
+    template<typename T> const TQuat<T> TQuat<T>::Identity = TQuat<T>(0, 0, 0, 1);
+    // template statics are initialized in no set order, so none of them may read another one
+    template<typename T> const TTransform<T> TTransform<T>::Identity = TTransform<T>(TQuat<T>(0, 0, 0, 1), TVector<T>(0, 0, 0), TVector<T>(1, 1, 1));
+
+    // scalar type of the retarget math, picked at compile time (see IKRIG_FLOAT_PRECISION in CMakeLists.txt)
+    #ifdef SOULIK_FLOAT_PRECISION
+    using FReal = float;
+    #else
+    using FReal = double;
+    #endif
+
+    using FVector = TVector<FReal>;
+    using FRotator = TRotator<FReal>;
+    using FQuat = TQuat<FReal>;
+    using FTransform = TTransform<FReal>;
+
+    using FVector3f = TVector<float>;
+    using FVector3d = TVector<double>;
+    using FQuat4f = TQuat<float>;
+    using FQuat4d = TQuat<double>;
+    using FTransform3f = TTransform<float>;
+    using FTransform3d = TTransform<double>;
+}
@@ -0,0 +1,66 @@
+//
+//  SoulFTransformBatch.cpp
+//
+//  batch kernels over contiguous FTransform arrays
+//
+
+#include "SoulFTransformBatch.h"
+
+namespace SoulIK
+{
+    void MultiplyN(FTransform* Out, const FTransform* A, const FTransform* B, int32 Num)
+    {
+        for (int32 i = 0; i < Num; ++i)
+        {
+            TransformKernel::Multiply(Out[i], A[i], B[i]);
+        }
+    }
+
+    void RelativeN(FTransform* Out, const FTransform* A, const FTransform* B, int32 Num)
+    {
+        for (int32 i = 0; i < Num; ++i)
+        {
+            TransformKernel::Relative(Out[i], A[i], B[i]);
+        }
+    }
+
+    void InverseN(FTransform* Out, const FTransform* A, int32 Num)
+    {
+        for (int32 i = 0; i < Num; ++i)
+        {
+            TransformKernel::Inverse(Out[i], A[i]);
+        }
+    }
+
+    void MultiplyParentN(FTransform* Global, const FTransform* Local, const int32* Bones, const int32* Parents, int32 Num)
+    {
+        for (int32 i = 0; i < Num; ++i)
+        {
+            TransformKernel::Multiply(Global[Bones[i]], Local[Bones[i]], Global[Parents[i]]);
+        }
+    }
+
+    void RelativeParentN(FTransform* Local, const FTransform* Global, const int32* Bones, const int32* Parents, int32 Num)
+    {
+        for (int32 i = 0; i < Num; ++i)
+        {
+            TransformKernel::Relative(Local[Bones[i]], Global[Bones[i]], Global[Parents[i]]);
+        }
+    }
+
+    void NormalizeN(FQuat* Out, const FQuat* Q, int32 Num)
+    {
+        for (int32 i = 0; i < Num; ++i)
+        {
+            TransformKernel::Normalize(Out[i], Q[i]);
+        }
+    }
+
+    void NLerpN(FQuat* Out, const FQuat* A, const FQuat* B, FReal Alpha, int32 Num)
+    {
+        for (int32 i = 0; i < Num; ++i)
+        {
+            TransformKernel::NLerp(Out[i], A[i], B[i], Alpha);
+        }
+    }
+}
@@ -0,0 +1,486 @@
+//
+//  SoulFTransformBatch.h
+//
+//  batch kernels over contiguous FTransform arrays
+//
+
+#pragma once
+
+#include "SoulFTransform.h"
+
+// code path is picked at compile time from the target flags (see IKRIG_SIMD in CMakeLists.txt)
+//   AVX2: double, one transform component per 256 bit register (quat wxyz, vec xyz_)
+//   SSE4: double, same math split into two 128 bit halves
+//   float (SOULIK_FLOAT_PRECISION): one component per 128 bit register with either flag
+//   none: falls back to the scalar FTransform methods
+#if defined(__AVX2__)
+    #define SOULIK_SIMD_AVX2 1
+    #include <immintrin.h>
+#elif defined(__SSE4_1__)
+    #define SOULIK_SIMD_SSE4 1
+    #include <immintrin.h>
+#endif
+
+// same semantic as FTransform (child_global = child_local * parent_global):
+//   MultiplyN:  Out[i] = A[i] * B[i]
+//   RelativeN:  Out[i] = A[i].GetRelativeTransform(B[i])
+//   InverseN:   Out[i] = A[i].Inverse()
+// Out may alias A or B element by element
+// transforms with negative scale go through the scalar (matrix) path, like FTransform does
+
+namespace SoulIK
+{
+    void MultiplyN(FTransform* Out, const FTransform* A, const FTransform* B, int32 Num);
+    void RelativeN(FTransform* Out, const FTransform* A, const FTransform* B, int32 Num);
+    void InverseN(FTransform* Out, const FTransform* A, int32 Num);
+
+    // indexed parent/child kernels over a set of independent bones (ie. one hierarchy level, see FBoneLevels)
+    //   MultiplyParentN: Global[Bones[i]] = Local[Bones[i]] * Global[Parents[i]]
+    //   RelativeParentN: Local[Bones[i]] = Global[Bones[i]].GetRelativeTransform(Global[Parents[i]])
+    // no parent may be one of the Bones
+    void MultiplyParentN(FTransform* Global, const FTransform* Local, const int32* Bones, const int32* Parents, int32 Num);
+    void RelativeParentN(FTransform* Local, const FTransform* Global, const int32* Bones, const int32* Parents, int32 Num);
+
+    // quaternion batch kernels, Out may alias the inputs
+    //   NormalizeN: Out[i] = Q[i].GetNormalized()
+    //   NLerpN:     Out[i] = FQuat::FastLerp(A[i], B[i], Alpha).GetNormalized()
+    // with SSE4/AVX2 the normalization uses a refined reciprocal sqrt (see TransformKernel::ReciprocalSqrt),
+    // |Out[i]| - 1 stays below 1e-13 for double and 3e-7 for float
+    void NormalizeN(FQuat* Out, const FQuat* Q, int32 Num);
+    void NLerpN(FQuat* Out, const FQuat* A, const FQuat* B, FReal Alpha, int32 Num);
+
+    namespace TransformKernel
+    {
+#if defined(SOULIK_SIMD_AVX2) || defined(SOULIK_SIMD_SSE4)
+
+        template<typename V> V Set(typename V::Scalar a0, typename V::Scalar a1, typename V::Scalar a2, typename V::Scalar a3);
+        template<typename V> V Splat(typename V::Scalar a);
+
+        // 4 floats in one register
+        struct F4f {
+            using Scalar = float;
+            __m128 v;
+        };
+
+        inline F4f Load4(const float* p) { return { _mm_loadu_ps(p) }; }
+        inline F4f Load3(const float* p) { return { _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(p)), _mm_load_ss(p + 2)) }; }
+        inline void Store4(float* p, F4f a) { _mm_storeu_ps(p, a.v); }
+        inline void Store3(float* p, F4f a) { _mm_storel_pi(reinterpret_cast<__m64*>(p), a.v); _mm_store_ss(p + 2, _mm_movehl_ps(a.v, a.v)); }
+        template<> inline F4f Set<F4f>(float a0, float a1, float a2, float a3) { return { _mm_setr_ps(a0, a1, a2, a3) }; }
+        template<> inline F4f Splat<F4f>(float a) { return { _mm_set1_ps(a) }; }
+
+        inline F4f Add(F4f a, F4f b) { return { _mm_add_ps(a.v, b.v) }; }
+        inline F4f Sub(F4f a, F4f b) { return { _mm_sub_ps(a.v, b.v) }; }
+        inline F4f Mul(F4f a, F4f b) { return { _mm_mul_ps(a.v, b.v) }; }
+        inline F4f Div(F4f a, F4f b) { return { _mm_div_ps(a.v, b.v) }; }
+        inline F4f MulAdd(F4f a, F4f b, F4f c) {
+        #if defined(__FMA__)
+            return { _mm_fmadd_ps(a.v, b.v, c.v) };
+        #else
+            return { _mm_add_ps(_mm_mul_ps(a.v, b.v), c.v) };
+        #endif
+        }
+        inline F4f SelectAbsGreater(F4f a, double tol, F4f b) {
+            const __m128 absA = _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v);
+            const __m128 mask = _mm_cmpgt_ps(absA, _mm_set1_ps(float(tol)));
+            return { _mm_and_ps(mask, b.v) };
+        }
+
+        inline F4f Swap01_23(F4f a) { return { _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(2, 3, 0, 1)) }; }
+        inline F4f SwapHalves(F4f a) { return { _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(1, 0, 3, 2)) }; }
+        inline F4f Splat0(F4f a) { return { _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(0, 0, 0, 0)) }; }
+        inline F4f Shift123(F4f a) { return { _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(0, 3, 2, 1)) }; }
+        inline float Lane0(F4f a) { return _mm_cvtss_f32(a.v); }
+        inline F4f YZX(F4f a) { return { _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(3, 0, 2, 1)) }; }
+        inline F4f ZXY(F4f a) { return { _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(3, 1, 0, 2)) }; }
+
+    #if defined(SOULIK_SIMD_AVX2)
+        // 4 doubles in one register
+        struct F4d {
+            using Scalar = double;
+            __m256d v;
+        };
+
+        inline F4d Load4(const double* p) { return { _mm256_loadu_pd(p) }; }
+        inline F4d Load3(const double* p) { return { _mm256_maskload_pd(p, _mm256_set_epi64x(0, -1, -1, -1)) }; }
+        inline void Store4(double* p, F4d a) { _mm256_storeu_pd(p, a.v); }
+        inline void Store3(double* p, F4d a) { _mm256_maskstore_pd(p, _mm256_set_epi64x(0, -1, -1, -1), a.v); }
+        template<> inline F4d Set<F4d>(double a0, double a1, double a2, double a3) { return { _mm256_setr_pd(a0, a1, a2, a3) }; }
+        template<> inline F4d Splat<F4d>(double a) { return { _mm256_set1_pd(a) }; }
+
+        inline F4d Add(F4d a, F4d b) { return { _mm256_add_pd(a.v, b.v) }; }
+        inline F4d Sub(F4d a, F4d b) { return { _mm256_sub_pd(a.v, b.v) }; }
+        inline F4d Mul(F4d a, F4d b) { return { _mm256_mul_pd(a.v, b.v) }; }
+        inline F4d Div(F4d a, F4d b) { return { _mm256_div_pd(a.v, b.v) }; }
+        inline F4d MulAdd(F4d a, F4d b, F4d c) {
+        #if defined(__FMA__)
+            return { _mm256_fmadd_pd(a.v, b.v, c.v) };
+        #else
+            return { _mm256_add_pd(_mm256_mul_pd(a.v, b.v), c.v) };
+        #endif
+        }
+        // |a| > tol ? b : 0
+        inline F4d SelectAbsGreater(F4d a, double tol, F4d b) {
+            const __m256d absA = _mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v);
+            const __m256d mask = _mm256_cmp_pd(absA, _mm256_set1_pd(tol), _CMP_GT_OQ);
+            return { _mm256_and_pd(mask, b.v) };
+        }
+
+        // lane shuffles, named after the result for input (a0 a1 a2 a3)
+        inline F4d Swap01_23(F4d a) { return { _mm256_permute_pd(a.v, 0x5) }; }               // a1 a0 a3 a2
+        inline F4d SwapHalves(F4d a) { return { _mm256_permute2f128_pd(a.v, a.v, 0x1) }; }    // a2 a3 a0 a1
+        inline F4d Splat0(F4d a) { return { _mm256_permute4x64_pd(a.v, 0x00) }; }             // a0 a0 a0 a0
+        inline F4d Shift123(F4d a) { return { _mm256_permute4x64_pd(a.v, 0x39) }; }           // a1 a2 a3 a0
+        inline double Lane0(F4d a) { return _mm256_cvtsd_f64(a.v); }
+        inline F4d YZX(F4d a) { return { _mm256_permute4x64_pd(a.v, 0xC9) }; }                // a1 a2 a0 a3
+        inline F4d ZXY(F4d a) { return { _mm256_permute4x64_pd(a.v, 0xD2) }; }                // a2 a0 a1 a3
+    #else
+        // 4 doubles in two registers: lo = (a0 a1), hi = (a2 a3)
+        struct F4d {
+            using Scalar = double;
+            __m128d lo;
+            __m128d hi;
+        };
+
+        inline F4d Load4(const double* p) { return { _mm_loadu_pd(p), _mm_loadu_pd(p + 2) }; }
+        inline F4d Load3(const double* p) { return { _mm_loadu_pd(p), _mm_load_sd(p + 2) }; }
+        inline void Store4(double* p, F4d a) { _mm_storeu_pd(p, a.lo); _mm_storeu_pd(p + 2, a.hi); }
+        inline void Store3(double* p, F4d a) { _mm_storeu_pd(p, a.lo); _mm_store_sd(p + 2, a.hi); }
+        template<> inline F4d Set<F4d>(double a0, double a1, double a2, double a3) { return { _mm_setr_pd(a0, a1), _mm_setr_pd(a2, a3) }; }
+        template<> inline F4d Splat<F4d>(double a) { return { _mm_set1_pd(a), _mm_set1_pd(a) }; }
+
+        inline F4d Add(F4d a, F4d b) { return { _mm_add_pd(a.lo, b.lo), _mm_add_pd(a.hi, b.hi) }; }
+        inline F4d Sub(F4d a, F4d b) { return { _mm_sub_pd(a.lo, b.lo), _mm_sub_pd(a.hi, b.hi) }; }
+        inline F4d Mul(F4d a, F4d b) { return { _mm_mul_pd(a.lo, b.lo), _mm_mul_pd(a.hi, b.hi) }; }
+        inline F4d Div(F4d a, F4d b) { return { _mm_div_pd(a.lo, b.lo), _mm_div_pd(a.hi, b.hi) }; }
+        inline F4d MulAdd(F4d a, F4d b, F4d c) { return Add(Mul(a, b), c); }
+        inline F4d SelectAbsGreater(F4d a, double tol, F4d b) {
+            const __m128d sign = _mm_set1_pd(-0.0);
+            const __m128d t = _mm_set1_pd(tol);
+            const __m128d maskLo = _mm_cmpgt_pd(_mm_andnot_pd(sign, a.lo), t);
+            const __m128d maskHi = _mm_cmpgt_pd(_mm_andnot_pd(sign, a.hi), t);
+            return { _mm_and_pd(maskLo, b.lo), _mm_and_pd(maskHi, b.hi) };
+        }
+
+        inline F4d Swap01_23(F4d a) { return { _mm_shuffle_pd(a.lo, a.lo, 0x1), _mm_shuffle_pd(a.hi, a.hi, 0x1) }; }
+        inline F4d SwapHalves(F4d a) { return { a.hi, a.lo }; }
+        inline F4d Splat0(F4d a) { return { _mm_unpacklo_pd(a.lo, a.lo), _mm_unpacklo_pd(a.lo, a.lo) }; }
+        inline F4d Shift123(F4d a) { return { _mm_shuffle_pd(a.lo, a.hi, 0x1), _mm_shuffle_pd(a.hi, a.lo, 0x1) }; }
+        inline double Lane0(F4d a) { return _mm_cvtsd_f64(a.lo); }
+        inline F4d YZX(F4d a) { return { _mm_shuffle_pd(a.lo, a.hi, 0x1), _mm_blend_pd(a.hi, a.lo, 0x1) }; }
+        inline F4d ZXY(F4d a) { return { _mm_shuffle_pd(a.hi, a.lo, 0x0), _mm_shuffle_pd(a.lo, a.hi, 0x3) }; }
+    #endif
+
+        template<typename T> struct TLanes;
+        template<> struct TLanes<double> { using Type = F4d; };
+        template<> struct TLanes<float> { using Type = F4f; };
+
+        // glm::qua storage is w x y z, TVector storage is x y z
+        template<typename T> inline const T* Ptr(const TQuat<T>& q) { return reinterpret_cast<const T*>(&q); }
+        template<typename T> inline T* Ptr(TQuat<T>& q) { return reinterpret_cast<T*>(&q); }
+        template<typename T> inline const T* Ptr(const TVector<T>& v) { return reinterpret_cast<const T*>(&v); }
+        template<typename T> inline T* Ptr(TVector<T>& v) { return reinterpret_cast<T*>(&v); }
+
+        // q1 * q2, both stored (w x y z)
+        template<typename V>
+        inline V QuatMul(V a, V b)
+        {
+            // w = aw*bw - ax*bx - ay*by - az*bz
+            // x = aw*bx + ax*bw + ay*bz - az*by
+            // y = aw*by - ax*bz + ay*bw + az*bx
+            // z = aw*bz + ax*by - ay*bx + az*bw
+            const V aw = Splat0(a);
+            const V ax = Splat0(Shift123(a));
+            const V ay = Splat0(SwapHalves(a));
+            const V az = Splat0(Shift123(SwapHalves(a)));
+
+            const V b1 = Swap01_23(b);      // bx bw bz by
+            const V b2 = SwapHalves(b);     // by bz bw bx
+            const V b3 = Swap01_23(b2);     // bz by bx bw
+
+            V r = Mul(aw, b);
+            r = MulAdd(Mul(ax, b1), Set<V>(-1,  1, -1,  1), r);
+            r = MulAdd(Mul(ay, b2), Set<V>(-1,  1,  1, -1), r);
+            r = MulAdd(Mul(az, b3), Set<V>(-1, -1,  1,  1), r);
+            return r;
+        }
+
+        template<typename V>
+        inline V QuatConjugate(V q)
+        {
+            return Mul(q, Set<V>(1, -1, -1, -1));
+        }
+
+        template<typename V>
+        inline V Cross(V a, V b)
+        {
+            return Sub(Mul(YZX(a), ZXY(b)), Mul(ZXY(a), YZX(b)));
+        }
+
+        // V' = V + w*T + (Q x T), T = 2*(Q x V), same as FQuat::RotateVector
+        template<typename V>
+        inline V QuatRotate(V q, V v)
+        {
+            const V qv = Shift123(q);       // x y z w
+            const V w = Splat0(q);
+            const V t = Mul(Cross(qv, v), Splat<V>(2));
+            return Add(MulAdd(w, t, v), Cross(qv, t));
+        }
+
+        // same as FTransform::GetSafeScaleReciprocal
+        template<typename V>
+        inline V SafeReciprocal(V s, double Tolerance = ZeroTolerance)
+        {
+            return SelectAbsGreater(s, Tolerance, Div(Splat<V>(1), s));
+        }
+
+        // a.b in every lane
+        template<typename V>
+        inline V Dot4(V a, V b)
+        {
+            const V m = Mul(a, b);
+            const V t = Add(m, Swap01_23(m));
+            return Add(t, SwapHalves(t));
+        }
+
+        // 1/sqrt(x) from the 12 bit rsqrtss estimate (rel err <= 1.5*2^-12) refined by Newton steps,
+        // each step squares the error: y' = y*(1.5 - 0.5*x*y*y), err' ~= 1.5*err^2
+        //   double: 2 steps, rel err < 1e-13
+        //   float:  1 step,  rel err < 3e-7 (~2.5 ulp)
+        template<typename T>
+        inline T ReciprocalSqrt(T x)
+        {
+            T y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(float(x))));
+            y = y * (T(1.5) - T(0.5) * x * y * y);
+            if constexpr (sizeof(T) > sizeof(float))
+            {
+                y = y * (T(1.5) - T(0.5) * x * y * y);
+            }
+            return y;
+        }
+
+        template<typename T>
+        inline bool AnyHasNegativeScale(const TVector<T>& AS, const TVector<T>& BS)
+        {
+            return AS.x < 0 || AS.y < 0 || AS.z < 0
+                || BS.x < 0 || BS.y < 0 || BS.z < 0;
+        }
+
+        // component form, so poses stored as separate rotation / translation / scale arrays
+        // (SoulPoseSoA.h) run the same kernels as FTransform arrays
+        template<typename T>
+        inline void Multiply(
+            TQuat<T>& OutR, TVector<T>& OutT, TVector<T>& OutS,
+            const TQuat<T>& AR, const TVector<T>& AT, const TVector<T>& AS,
+            const TQuat<T>& BR, const TVector<T>& BT, const TVector<T>& BS)
+        {
+            using V = typename TLanes<T>::Type;
+            if (AnyHasNegativeScale(AS, BS))
+            {
+                const TTransform<T> Result = TTransform<T>(AR, AT, AS) * TTransform<T>(BR, BT, BS);
+                OutR = Result.Rotation;
+                OutT = Result.Translation;
+                OutS = Result.Scale3D;
+                return;
+            }
+
+            //	Q(AxB) = Q(B)*Q(A)
+            //	S(AxB) = S(A)*S(B)
+            //	T(AxB) = Q(B)*S(B)*T(A)*-Q(B) + T(B)
+            const V qa = Load4(Ptr(AR));
+            const V qb = Load4(Ptr(BR));
+            const V ta = Load3(Ptr(AT));
+            const V tb = Load3(Ptr(BT));
+            const V sa = Load3(Ptr(AS));
+            const V sb = Load3(Ptr(BS));
+
+            const V q = QuatMul(qb, qa);
+            const V s = Mul(sa, sb);
+            const V t = Add(QuatRotate(qb, Mul(sb, ta)), tb);
+
+            Store4(Ptr(OutR), q);
+            Store3(Ptr(OutS), s);
+            Store3(Ptr(OutT), t);
+        }
+
+        template<typename T>
+        inline void Relative(
+            TQuat<T>& OutR, TVector<T>& OutT, TVector<T>& OutS,
+            const TQuat<T>& AR, const TVector<T>& AT, const TVector<T>& AS,
+            const TQuat<T>& BR, const TVector<T>& BT, const TVector<T>& BS)
+        {
+            using V = typename TLanes<T>::Type;
+            if (AnyHasNegativeScale(AS, BS))
+            {
+                const TTransform<T> Result = TTransform<T>(AR, AT, AS).GetRelativeTransform(TTransform<T>(BR, BT, BS));
+                OutR = Result.Rotation;
+                OutT = Result.Translation;
+                OutS = Result.Scale3D;
+                return;
+            }
+
+            // Scale = S(A)/S(B)
+            // Rotation = Q(B)(-1) * Q(A)
+            // Translation = 1/S(B) *[Q(B)(-1)*(T(A)-T(B))*Q(B)]
+            const V qa = Load4(Ptr(AR));
+            const V qb = Load4(Ptr(BR));
+            const V ta = Load3(Ptr(AT));
+            const V tb = Load3(Ptr(BT));
+            const V sa = Load3(Ptr(AS));
+            const V sb = Load3(Ptr(BS));
+
+            const V invqb = QuatConjugate(qb);
+            const V recipsb = SafeReciprocal(sb, UE_SMALL_NUMBER);
+
+            const V q = QuatMul(invqb, qa);
+            const V s = Mul(sa, recipsb);
+            const V t = Mul(QuatRotate(invqb, Sub(ta, tb)), recipsb);
+
+            Store4(Ptr(OutR), q);
+            Store3(Ptr(OutS), s);
+            Store3(Ptr(OutT), t);
+        }
+
+        template<typename T>
+        inline void Inverse(
+            TQuat<T>& OutR, TVector<T>& OutT, TVector<T>& OutS,
+            const TQuat<T>& AR, const TVector<T>& AT, const TVector<T>& AS)
+        {
+            using V = typename TLanes<T>::Type;
+            const V qa = Load4(Ptr(AR));
+            const V ta = Load3(Ptr(AT));
+            const V sa = Load3(Ptr(AS));
+
+            const V invq = QuatConjugate(qa);
+            const V invs = SafeReciprocal(sa);
+            const V invt = QuatRotate(invq, Mul(invs, Sub(Splat<V>(0), ta)));
+
+            Store4(Ptr(OutR), invq);
+            Store3(Ptr(OutS), invs);
+            Store3(Ptr(OutT), invt);
+        }
+
+        // same result as FQuat::Normalize within the ReciprocalSqrt bound
+        template<typename T>
+        inline void Normalize(TQuat<T>& Out, const TQuat<T>& Q)
+        {
+            using V = typename TLanes<T>::Type;
+            const V q = Load4(Ptr(Q));
+            const T SquareSum = Lane0(Dot4(q, q));
+            if (SquareSum < UE_SMALL_NUMBER)
+            {
+                Out = TQuat<T>::Identity;
+                return;
+            }
+            Store4(Ptr(Out), Mul(q, Splat<V>(ReciprocalSqrt(SquareSum))));
+        }
+
+        // FQuat::FastLerp(A, B, Alpha).GetNormalized()
+        template<typename T>
+        inline void NLerp(TQuat<T>& Out, const TQuat<T>& A, const TQuat<T>& B, const double InAlpha)
+        {
+            const T Alpha = T(InAlpha);
+            using V = typename TLanes<T>::Type;
+            const V a = Load4(Ptr(A));
+            const V b = Load4(Ptr(B));
+
+            // shortest route: flip A when the rotations are more than 180 degrees apart
+            const T Bias = Lane0(Dot4(a, b)) >= 0 ? T(1) : T(-1);
+            const V q = MulAdd(a, Splat<V>(Bias * (T(1) - Alpha)), Mul(b, Splat<V>(Alpha)));
+
+            const T SquareSum = Lane0(Dot4(q, q));
+            if (SquareSum < UE_SMALL_NUMBER)
+            {
+                Out = TQuat<T>::Identity;
+                return;
+            }
+            Store4(Ptr(Out), Mul(q, Splat<V>(ReciprocalSqrt(SquareSum))));
+        }
+
+#else  // scalar
+
+        template<typename T>
+        inline void Multiply(
+            TQuat<T>& OutR, TVector<T>& OutT, TVector<T>& OutS,
+            const TQuat<T>& AR, const TVector<T>& AT, const TVector<T>& AS,
+            const TQuat<T>& BR, const TVector<T>& BT, const TVector<T>& BS)
+        {
+            const TTransform<T> Result = TTransform<T>(AR, AT, AS) * TTransform<T>(BR, BT, BS);
+            OutR = Result.Rotation;
+            OutT = Result.Translation;
+            OutS = Result.Scale3D;
+        }
+
+        template<typename T>
+        inline void Relative(
+            TQuat<T>& OutR, TVector<T>& OutT, TVector<T>& OutS,
+            const TQuat<T>& AR, const TVector<T>& AT, const TVector<T>& AS,
+            const TQuat<T>& BR, const TVector<T>& BT, const TVector<T>& BS)
+        {
+            const TTransform<T> Result = TTransform<T>(AR, AT, AS).GetRelativeTransform(TTransform<T>(BR, BT, BS));
+            OutR = Result.Rotation;
+            OutT = Result.Translation;
+            OutS = Result.Scale3D;
+        }
+
+        template<typename T>
+        inline void Inverse(
+            TQuat<T>& OutR, TVector<T>& OutT, TVector<T>& OutS,
+            const TQuat<T>& AR, const TVector<T>& AT, const TVector<T>& AS)
+        {
+            const TTransform<T> Result = TTransform<T>(AR, AT, AS).Inverse();
+            OutR = Result.Rotation;
+            OutT = Result.Translation;
+            OutS = Result.Scale3D;
+        }
+
+        template<typename T>
+        inline void Normalize(TQuat<T>& Out, const TQuat<T>& Q)
+        {
+            Out = Q.GetNormalized();
+        }
+
+        template<typename T>
+        inline void NLerp(TQuat<T>& Out, const TQuat<T>& A, const TQuat<T>& B, const double Alpha)
+        {
+            Out = TQuat<T>::FastLerp(A, B, Alpha).GetNormalized();
+        }
+
+#endif
+
+        template<typename T>
+        inline void Multiply(TTransform<T>& Out, const TTransform<T>& A, const TTransform<T>& B)
+        {
+        #if defined(SOULIK_SIMD_AVX2) || defined(SOULIK_SIMD_SSE4)
+            Multiply(Out.Rotation, Out.Translation, Out.Scale3D,
+                A.Rotation, A.Translation, A.Scale3D,
+                B.Rotation, B.Translation, B.Scale3D);
+        #else
+            Out = A * B;
+        #endif
+        }
+
+        template<typename T>
+        inline void Relative(TTransform<T>& Out, const TTransform<T>& A, const TTransform<T>& B)
+        {
+        #if defined(SOULIK_SIMD_AVX2) || defined(SOULIK_SIMD_SSE4)
+            Relative(Out.Rotation, Out.Translation, Out.Scale3D,
+                A.Rotation, A.Translation, A.Scale3D,
+                B.Rotation, B.Translation, B.Scale3D);
+        #else
+            Out = A.GetRelativeTransform(B);
+        #endif
+        }
+
+        template<typename T>
+        inline void Inverse(TTransform<T>& Out, const TTransform<T>& A)
+        {
+        #if defined(SOULIK_SIMD_AVX2) || defined(SOULIK_SIMD_SSE4)
+            Inverse(Out.Rotation, Out.Translation, Out.Scale3D,
+                A.Rotation, A.Translation, A.Scale3D);
+        #else
+            Out = A.Inverse();
+        #endif
+        }
+    }
+}
@@ -6,6 +6,7 @@
 //
 
 #include "SoulIKRetargetProcessor.h"
+#include "SoulFTransformBatch.h"
 #include <algorithm>
 #include <tuple>
 
@@ -13,7 +14,6 @@
 // #define DEBUG_POSE_LOG_CHAINFK
 // #define DEBUG_POSE_LOG_ROOT
 
-#define RETARGETSKELETON_INVALID_BRANCH_INDEX -2
 
 using namespace SoulIK;
 
@@ -36,12 +36,28 @@ void FRetargetSkeleton::Initialize(
 	// record which skeletal mesh this is running on
 	Skeleton = InSkeleton;
 	
-	// copy names and parent indices into local storage
+	// sort the hierarchy parent before child, every per-bone array below is in that order
 	const USkeleton* RefSkeleton = Skeleton;
+	TArray<int32> FileParentIndices(RefSkeleton->GetNum());
 	for (int32 BoneIndex=0; BoneIndex<RefSkeleton->GetNum(); ++BoneIndex)
 	{
-		BoneNames.push_back(RefSkeleton->GetBoneName(BoneIndex));
-		ParentIndices.push_back(RefSkeleton->GetParentIndex(BoneIndex));	
+		FileParentIndices[BoneIndex] = RefSkeleton->GetParentIndex(BoneIndex);
+	}
+	HierarchyError = Hierarchy.Initialize(FileParentIndices);
+	if (HierarchyError != EHierarchyError::None)
+	{
+		return;
+	}
+
+	// copy names and parent indices into local storage
+	ParentIndices = Hierarchy.ParentIndices;
+	Levels.Initialize(ParentIndices);
+	BoneNames.reserve(Hierarchy.Num());
+	BoneIndexByName.reserve(Hierarchy.Num());
+	for (int32 BoneIndex=0; BoneIndex<Hierarchy.Num(); ++BoneIndex)
+	{
+		BoneNames.push_back(RefSkeleton->GetBoneName(Hierarchy.SortedToFile[BoneIndex]));
+		BoneIndexByName.emplace(BoneNames.back(), BoneIndex);
 	}
 
 	// determine set of bones referenced by one of the retarget bone chains
@@ -59,9 +75,6 @@ void FRetargetSkeleton::Initialize(
 		}
 	}
 
-	// initialize branch caching
-	//CachedEndOfBranchIndices.Init(RETARGETSKELETON_INVALID_BRANCH_INDEX, ParentIndices.Num());
-
 	// update retarget pose to reflect custom offsets (applies stored offsets)
 	// NOTE: this must be done AFTER generating IsBoneInAnyTargetChain array above
 	GenerateRetargetPose(InRetargetPoseName, RetargetPose, RetargetRootBone);
@@ -70,9 +83,16 @@ void FRetargetSkeleton::Initialize(
 void FRetargetSkeleton::Reset()
 {
 	BoneNames.clear();
+	BoneIndexByName.clear();
 	ParentIndices.clear();
 	RetargetLocalPose.clear();
 	RetargetGlobalPose.clear();
+	RetargetLocalDualQuats.clear();
+	Hierarchy.Reset();
+	HierarchyError = EHierarchyError::None;
+	Levels.Reset();
+	bUpdateByLevel = false;
+	ParallelLevelMinBones = INDEX_NONE;
 	Skeleton = nullptr;
 }
 
@@ -85,7 +105,7 @@ void FRetargetSkeleton::GenerateRetargetPose(
 	RetargetPoseName = InRetargetPoseName;
 	
 	// initialize retarget pose to the skeletal mesh reference pose
-	RetargetLocalPose = Skeleton->GetRefBonePose();
+	Hierarchy.ToSorted(Skeleton->GetRefBonePose(), RetargetLocalPose);
 	// copy local pose to global
 	RetargetGlobalPose = RetargetLocalPose;
 	// convert to global space
@@ -98,7 +118,8 @@ void FRetargetSkeleton::GenerateRetargetPose(
 	}
 
 	// apply retarget pose offsets (retarget pose is stored as offset relative to reference pose)
-	const TArray<FTransform>& RefPoseLocal = Skeleton->GetRefBonePose();
+	TArray<FTransform> RefPoseLocal;
+	Hierarchy.ToSorted(Skeleton->GetRefBonePose(), RefPoseLocal);
 	
 	// apply root translation offset
 	const int32 RootBoneIndex = FindBoneIndexByName(RetargetRootBone);
@@ -129,12 +150,8 @@ void FRetargetSkeleton::GenerateRetargetPose(
 
 int32 FRetargetSkeleton::FindBoneIndexByName(const FName InName) const
 {
-	auto it = std::find(BoneNames.begin(), BoneNames.end(), InName);
-	if (it == BoneNames.end()) {
-		return -1;
-	} else {
-		return static_cast<int32_t>(std::distance(BoneNames.begin(), it));
-	}
+	auto it = BoneIndexByName.find(InName);
+	return it == BoneIndexByName.end() ? INDEX_NONE : it->second;
 }
 
 void FRetargetSkeleton::UpdateGlobalTransformsBelowBone(
@@ -146,12 +163,70 @@ void FRetargetSkeleton::UpdateGlobalTransformsBelowBone(
 	//check(BoneNames.Num() == InLocalPose.Num());
 	//check(BoneNames.Num() == OutGlobalPose.Num());
 	
+	if (bUpdateByLevel)
+	{
+		Levels.LocalToGlobal(InLocalPose.data(), OutGlobalPose.data(), StartBoneIndex, ParallelLevelMinBones);
+		return;
+	}
+
 	for (int32 BoneIndex=StartBoneIndex+1; BoneIndex<OutGlobalPose.size(); ++BoneIndex)
 	{
 		UpdateGlobalTransformOfSingleBone(BoneIndex,InLocalPose,OutGlobalPose);
 	}
 }
 
+void FRetargetSkeleton::UpdateGlobalTransformsBelowBone(
+	const int32 StartBoneIndex,
+	const FPoseSoA& InLocalPose,
+	FPoseSoA& OutGlobalPose) const
+{
+	for (int32 BoneIndex=StartBoneIndex+1; BoneIndex<OutGlobalPose.Num(); ++BoneIndex)
+	{
+		const int32 ParentIndex = ParentIndices[BoneIndex];
+		if (ParentIndex == INDEX_NONE)
+		{
+			// root always in global space already, no conversion required
+			OutGlobalPose.Rotations[BoneIndex] = InLocalPose.Rotations[BoneIndex];
+			OutGlobalPose.Translations[BoneIndex] = InLocalPose.Translations[BoneIndex];
+			OutGlobalPose.Scales[BoneIndex] = InLocalPose.Scales[BoneIndex];
+			continue;
+		}
+		TransformKernel::Multiply(
+			OutGlobalPose.Rotations[BoneIndex], OutGlobalPose.Translations[BoneIndex], OutGlobalPose.Scales[BoneIndex],
+			InLocalPose.Rotations[BoneIndex], InLocalPose.Translations[BoneIndex], InLocalPose.Scales[BoneIndex],
+			OutGlobalPose.Rotations[ParentIndex], OutGlobalPose.Translations[ParentIndex], OutGlobalPose.Scales[ParentIndex]);
+	}
+}
+
+void FRetargetSkeleton::UpdateGlobalTransformsBelowBone(
+	const int32 StartBoneIndex,
+	const TArray<FDualQuat>& InLocalPose,
+	TArray<FDualQuat>& ScratchGlobalPose,
+	TArray<FTransform>& OutGlobalPose) const
+{
+	// parents above the start bone are read from the incoming global pose
+	ScratchGlobalPose.resize(OutGlobalPose.size());
+	for (int32 BoneIndex=0; BoneIndex<=StartBoneIndex && BoneIndex<OutGlobalPose.size(); ++BoneIndex)
+	{
+		TransformKernel::ToDualQuat(ScratchGlobalPose[BoneIndex], OutGlobalPose[BoneIndex]);
+	}
+
+	for (int32 BoneIndex=StartBoneIndex+1; BoneIndex<OutGlobalPose.size(); ++BoneIndex)
+	{
+		const int32 ParentIndex = ParentIndices[BoneIndex];
+		if (ParentIndex == INDEX_NONE)
+		{
+			// root always in global space already, no conversion required
+			ScratchGlobalPose[BoneIndex] = InLocalPose[BoneIndex];
+		}
+		else
+		{
+			TransformKernel::Multiply(ScratchGlobalPose[BoneIndex], InLocalPose[BoneIndex], ScratchGlobalPose[ParentIndex]);
+		}
+		TransformKernel::ToTransform(OutGlobalPose[BoneIndex], ScratchGlobalPose[BoneIndex]);
+	}
+}
+
 void FRetargetSkeleton::UpdateLocalTransformsBelowBone(
 	const int32 StartBoneIndex,
 	TArray<FTransform>& OutLocalPose,
@@ -161,6 +236,12 @@ void FRetargetSkeleton::UpdateLocalTransformsBelowBone(
 	//check(BoneNames.Num() == OutLocalPose.Num());
 	//check(BoneNames.Num() == InGlobalPose.Num());
 	
+	if (bUpdateByLevel && StartBoneIndex == INDEX_NONE)
+	{
+		Levels.GlobalToLocal(InGlobalPose.data(), OutLocalPose.data(), ParallelLevelMinBones);
+		return;
+	}
+
 	for (int32 BoneIndex=StartBoneIndex+1; BoneIndex<InGlobalPose.size(); ++BoneIndex)
 	{
 		UpdateLocalTransformOfSingleBone(BoneIndex, OutLocalPose, InGlobalPose);
@@ -181,7 +262,7 @@ void FRetargetSkeleton::UpdateGlobalTransformOfSingleBone(
 	}
 	const FTransform& ChildLocalTransform = InLocalPose[BoneIndex];
 	const FTransform& ParentGlobalTransform = OutGlobalPose[ParentIndex];
-	OutGlobalPose[BoneIndex] = ChildLocalTransform * ParentGlobalTransform;
+	TransformKernel::Multiply(OutGlobalPose[BoneIndex], ChildLocalTransform, ParentGlobalTransform);
 }
 
 void FRetargetSkeleton::UpdateLocalTransformOfSingleBone(
@@ -198,7 +279,7 @@ void FRetargetSkeleton::UpdateLocalTransformOfSingleBone(
 	}
 	const FTransform& ChildGlobalTransform = InGlobalPose[BoneIndex];
 	const FTransform& ParentGlobalTransform = InGlobalPose[ParentIndex];
-	OutLocalPose[BoneIndex] = ChildGlobalTransform.GetRelativeTransform(ParentGlobalTransform);
+	TransformKernel::Relative(OutLocalPose[BoneIndex], ChildGlobalTransform, ParentGlobalTransform);
 }
 
 FTransform FRetargetSkeleton::GetGlobalRefPoseOfSingleBone(
@@ -215,73 +296,73 @@ FTransform FRetargetSkeleton::GetGlobalRefPoseOfSingleBone(
 	return ChildLocalTransform * ParentGlobalTransform;
 }
 
-int32 FRetargetSkeleton::GetCachedEndOfBranchIndex(const int32 InBoneIndex) const
+// dual quaternions carry no scale, a transform converts without loss only when this holds
+static bool HasUnitScale(const FTransform& Transform)
 {
-	if ( InBoneIndex >= CachedEndOfBranchIndices.size())
-	{
-		return INDEX_NONE;
-	}
+	const FVector& Scale = Transform.Scale3D;
+	return IsNearlyEqual(Scale.x, 1.0f, KINDA_SMALL_NUMBER) &&
+		IsNearlyEqual(Scale.y, 1.0f, KINDA_SMALL_NUMBER) &&
+		IsNearlyEqual(Scale.z, 1.0f, KINDA_SMALL_NUMBER);
+}
 
-	// already cached
-	if (CachedEndOfBranchIndices[InBoneIndex] != RETARGETSKELETON_INVALID_BRANCH_INDEX)
+bool FRetargetSkeleton::HasUnitScale() const
+{
+	for (const FTransform& LocalTransform : RetargetLocalPose)
 	{
-		return CachedEndOfBranchIndices[InBoneIndex];
+		if (!::HasUnitScale(LocalTransform))
+		{
+			return false;
+		}
 	}
+	return true;
+}
 
-	const int32 NumBones = static_cast<int32_t>(BoneNames.size());
-	
-	// if we're asking for root's branch, get the last bone  
-	if (InBoneIndex == 0)
+void FRetargetSkeleton::InitializeDualQuats()
+{
+	RetargetLocalDualQuats.resize(RetargetLocalPose.size());
+	for (int32 BoneIndex=0; BoneIndex<RetargetLocalPose.size(); ++BoneIndex)
 	{
-		CachedEndOfBranchIndices[InBoneIndex] = NumBones-1;
-		return CachedEndOfBranchIndices[InBoneIndex];
+		TransformKernel::ToDualQuat(RetargetLocalDualQuats[BoneIndex], RetargetLocalPose[BoneIndex]);
 	}
+}
 
-	CachedEndOfBranchIndices[InBoneIndex] = INDEX_NONE;
-	const int32 StartParentIndex = GetParentIndex(InBoneIndex);
-	int32 BoneIndex = InBoneIndex + 1;
-	int32 ParentIndex = GetParentIndex(BoneIndex);
-
-	// if next child bone's parent is less than or equal to StartParentIndex,
-	// we are leaving the branch so no need to go further
-	while (ParentIndex > StartParentIndex && BoneIndex < NumBones)
+int32 FRetargetSkeleton::GetEndOfBranchIndex(const int32 InBoneIndex) const
+{
+	if (InBoneIndex < 0 || InBoneIndex >= Hierarchy.Num())
 	{
-		CachedEndOfBranchIndices[InBoneIndex] = BoneIndex;
-				
-		BoneIndex++;
-		ParentIndex = GetParentIndex(BoneIndex);
+		return INDEX_NONE;
 	}
 
-	return CachedEndOfBranchIndices[InBoneIndex];
+	const int32 LastBranchIndex = Hierarchy.SubtreeEnd[InBoneIndex] - 1;
+	return LastBranchIndex > InBoneIndex ? LastBranchIndex : INDEX_NONE;
 }
 
 void FRetargetSkeleton::GetChildrenIndices(const int32 BoneIndex, TArray<int32>& OutChildren) const
 {
-	const int32 LastBranchIndex = GetCachedEndOfBranchIndex(BoneIndex);
+	const int32 LastBranchIndex = GetEndOfBranchIndex(BoneIndex);
 	if (LastBranchIndex == INDEX_NONE)
 	{
 		// no children (leaf bone)
 		return;
 	}
 	
-	for (int32 ChildBoneIndex = BoneIndex + 1; ChildBoneIndex <= LastBranchIndex; ChildBoneIndex++)
+	// direct children are the starts of consecutive subtrees, skip over each grandchild branch
+	for (int32 ChildBoneIndex = BoneIndex + 1; ChildBoneIndex <= LastBranchIndex; ChildBoneIndex = Hierarchy.SubtreeEnd[ChildBoneIndex])
 	{
-		if (GetParentIndex(ChildBoneIndex) == BoneIndex)
-		{
-			OutChildren.push_back(ChildBoneIndex);
-		}
+		OutChildren.push_back(ChildBoneIndex);
 	}
 }
 
 void FRetargetSkeleton::GetChildrenIndicesRecursive(const int32 BoneIndex, TArray<int32>& OutChildren) const
 {
-	const int32 LastBranchIndex = GetCachedEndOfBranchIndex(BoneIndex);
+	const int32 LastBranchIndex = GetEndOfBranchIndex(BoneIndex);
 	if (LastBranchIndex == INDEX_NONE)
 	{
 		// no children (leaf bone)
 		return;
 	}
 	
+	OutChildren.reserve(OutChildren.size() + LastBranchIndex - BoneIndex);
 	for (int32 ChildBoneIndex = BoneIndex + 1; ChildBoneIndex <= LastBranchIndex; ChildBoneIndex++)
 	{
 		OutChildren.push_back(ChildBoneIndex);
@@ -290,18 +371,12 @@ void FRetargetSkeleton::GetChildrenIndicesRecursive(const int32 BoneIndex, TArra
 
 bool FRetargetSkeleton::IsParentOfChild(const int32 PotentialParentIndex, const int32 ChildBoneIndex) const
 {
-	int32 ParentIndex = GetParentIndex(ChildBoneIndex);
-	while (ParentIndex != INDEX_NONE)
+	if (PotentialParentIndex < 0 || PotentialParentIndex >= Hierarchy.Num())
 	{
-		if (ParentIndex == PotentialParentIndex)
-		{
-			return true;
-		}
-		
-		ParentIndex = GetParentIndex(ParentIndex);
+		return false;
 	}
 	
-	return false;
+	return Hierarchy.IsDescendant(PotentialParentIndex, ChildBoneIndex);
 }
 
 int32 FRetargetSkeleton::GetParentIndex(const int32 BoneIndex) const
@@ -329,19 +404,17 @@ void FTargetSkeleton::Initialize(
 	// these are bones that are in a target chain that is mapped to a source chain (ie, will actually be retargeted)
 	// these flags are actually set later in init phase when bone chains are mapped together
 	IsBoneRetargeted.resize(BoneNames.size(), false);
-
-	// initialize storage for output pose (the result of the retargeting)
-	OutputGlobalPose = RetargetGlobalPose;
 }
 
 void FTargetSkeleton::Reset()
 {
 	FRetargetSkeleton::Reset();
-	OutputGlobalPose.clear();
 	IsBoneRetargeted.clear();
+	DirtyRetargetedBoneIndices.clear();
+	DirtyNonRetargetedBoneIndices.clear();
 }
 
-void FTargetSkeleton::UpdateGlobalTransformsAllNonRetargetedBones(TArray<FTransform>& InOutGlobalPose)
+void FTargetSkeleton::UpdateGlobalTransformsAllNonRetargetedBones(TArray<FTransform>& InOutGlobalPose) const
 {
 	//check(IsBoneRetargeted.Num() == InOutGlobalPose.Num());
 	
@@ -354,6 +427,62 @@ void FTargetSkeleton::UpdateGlobalTransformsAllNonRetargetedBones(TArray<FTransf
 	}
 }
 
+void FTargetSkeleton::InitializeDirtyBones(
+	const bool bRootDriven,
+	const bool bChainsDriven,
+	const int32 RootBoneIndex)
+{
+	DirtyRetargetedBoneIndices.clear();
+	DirtyNonRetargetedBoneIndices.clear();
+
+	// a bone is dirty if a stage writes it or any of its parents, parents come first so one pass is enough
+	TArray<bool> IsBoneDirty(BoneNames.size(), false);
+	for (int32 BoneIndex=0; BoneIndex<BoneNames.size(); ++BoneIndex)
+	{
+		const bool bIsRoot = BoneIndex == RootBoneIndex;
+		const bool bIsWritten = bIsRoot ? bRootDriven : (bChainsDriven && IsBoneRetargeted[BoneIndex]);
+		const int32 ParentIndex = ParentIndices[BoneIndex];
+		IsBoneDirty[BoneIndex] = bIsWritten || (ParentIndex != INDEX_NONE && IsBoneDirty[ParentIndex]);
+
+		if (bIsWritten)
+		{
+			DirtyRetargetedBoneIndices.push_back(BoneIndex);
+		}
+		else if (IsBoneDirty[BoneIndex] && !IsBoneRetargeted[BoneIndex])
+		{
+			DirtyNonRetargetedBoneIndices.push_back(BoneIndex);
+		}
+	}
+}
+
+void FTargetSkeleton::ResetDirtyRetargetedBones(TArray<FTransform>& InOutGlobalPose) const
+{
+	for (const int32 BoneIndex : DirtyRetargetedBoneIndices)
+	{
+		InOutGlobalPose[BoneIndex] = RetargetGlobalPose[BoneIndex];
+	}
+}
+
+void FTargetSkeleton::UpdateGlobalTransformsDirtyNonRetargetedBones(TArray<FTransform>& InOutGlobalPose) const
+{
+	for (const int32 BoneIndex : DirtyNonRetargetedBoneIndices)
+	{
+		UpdateGlobalTransformOfSingleBone(BoneIndex, RetargetLocalPose, InOutGlobalPose);
+	}
+}
+
+void FTargetSkeleton::CopyDirtyBonesToFileOrder(const TArray<FTransform>& InGlobalPose, TArray<FTransform>& InOutFileGlobalPose) const
+{
+	const TArray<int32>& SortedToFile = Hierarchy.SortedToFile;
+	for (const TArray<int32>* DirtyBoneIndices : {&DirtyRetargetedBoneIndices, &DirtyNonRetargetedBoneIndices})
+	{
+		for (const int32 BoneIndex : *DirtyBoneIndices)
+		{
+			InOutFileGlobalPose[SortedToFile[BoneIndex]] = InGlobalPose[BoneIndex];
+		}
+	}
+}
+
 FResolvedBoneChain::FResolvedBoneChain(
 	const FBoneChain& BoneChain,
 	const FRetargetSkeleton& Skeleton,
@@ -431,9 +560,6 @@ bool FChainFK::Initialize(
 		}
 	}
 
-	// initialize storage for current bones
-	CurrentGlobalTransforms = InitialGlobalTransforms;
-
 	// get the local space of the chain in retarget pose
 	InitialLocalTransforms.resize(InitialGlobalTransforms.size());
 	FillTransformsWithLocalSpaceOfChain(Skeleton, InitialGlobalPose, BoneIndices, InitialLocalTransforms);
@@ -491,6 +617,24 @@ bool FChainFK::Initialize(
 	return CalculateBoneParameters(Log);
 }
 
+void FChainFK::EnableDualQuat()
+{
+	bUseDualQuat = true;
+	InitialGlobalDualQuats.resize(InitialGlobalTransforms.size());
+	for (int32 ChainIndex=0; ChainIndex<InitialGlobalTransforms.size(); ++ChainIndex)
+	{
+		TransformKernel::ToDualQuat(InitialGlobalDualQuats[ChainIndex], InitialGlobalTransforms[ChainIndex]);
+	}
+}
+
+void FChainFK::InitializeState(FChainFKState& State) const
+{
+	State.CurrentGlobalTransforms = InitialGlobalTransforms;
+	State.CurrentGlobalDualQuats = InitialGlobalDualQuats;
+	State.CurrentLocalTransforms.resize(BoneIndices.size());
+	State.ChainParentCurrentGlobalTransform = ChainParentInitialGlobalTransform;
+}
+
 bool FChainFK::CalculateBoneParameters(FIKRigLogger& Log)
 {
 	Params.clear();
@@ -549,31 +693,49 @@ void FChainFK::FillTransformsWithLocalSpaceOfChain(
 
 		const FTransform& ChildGlobalTransform = InGlobalPose[BoneIndex];
 		const FTransform& ParentGlobalTransform = InGlobalPose[ParentIndex];
-		OutLocalTransforms[ChainIndex] = ChildGlobalTransform.GetRelativeTransform(ParentGlobalTransform);
+		TransformKernel::Relative(OutLocalTransforms[ChainIndex], ChildGlobalTransform, ParentGlobalTransform);
 	}
 }
 
 void FChainFK::PutCurrentTransformsInRefPose(
 	const TArray<int32>& InBoneIndices,
 	const FRetargetSkeleton& Skeleton,
-	const TArray<FTransform>& InCurrentGlobalPose)
+	const TArray<FTransform>& InCurrentGlobalPose,
+	FChainFKState& State) const
 {
 	// update chain current transforms to the retarget pose in global space
+	if (bUseDualQuat && !Skeleton.RetargetLocalDualQuats.empty())
+	{
+		for (int32 ChainIndex=0; ChainIndex<InBoneIndices.size(); ++ChainIndex)
+		{
+			const int32 BoneIndex = InBoneIndices[ChainIndex];
+			if (ChainIndex == 0)
+			{
+				State.CurrentGlobalTransforms[ChainIndex] = Skeleton.GetGlobalRefPoseOfSingleBone(BoneIndex, InCurrentGlobalPose);
+				TransformKernel::ToDualQuat(State.CurrentGlobalDualQuats[ChainIndex], State.CurrentGlobalTransforms[ChainIndex]);
+				continue;
+			}
+			TransformKernel::Multiply(State.CurrentGlobalDualQuats[ChainIndex], Skeleton.RetargetLocalDualQuats[BoneIndex], State.CurrentGlobalDualQuats[ChainIndex-1]);
+			TransformKernel::ToTransform(State.CurrentGlobalTransforms[ChainIndex], State.CurrentGlobalDualQuats[ChainIndex]);
+		}
+		return;
+	}
+
 	for (int32 ChainIndex=0; ChainIndex<InBoneIndices.size(); ++ChainIndex)
 	{
 		// update first bone in chain based on the incoming parent
 		if (ChainIndex == 0)
 		{
 			const int32 BoneIndex = InBoneIndices[ChainIndex];
-			CurrentGlobalTransforms[ChainIndex] = Skeleton.GetGlobalRefPoseOfSingleBone(BoneIndex, InCurrentGlobalPose);
+			State.CurrentGlobalTransforms[ChainIndex] = Skeleton.GetGlobalRefPoseOfSingleBone(BoneIndex, InCurrentGlobalPose);
 		}
 		else
 		{
 			// all subsequent bones in chain are based on previous parent
 			const int32 BoneIndex = InBoneIndices[ChainIndex];
-			const FTransform& ParentGlobalTransform = CurrentGlobalTransforms[ChainIndex-1];
+			const FTransform& ParentGlobalTransform = State.CurrentGlobalTransforms[ChainIndex-1];
 			const FTransform& ChildLocalTransform = Skeleton.RetargetLocalPose[BoneIndex];
-			CurrentGlobalTransforms[ChainIndex] = ChildLocalTransform * ParentGlobalTransform;
+			TransformKernel::Multiply(State.CurrentGlobalTransforms[ChainIndex], ChildLocalTransform, ParentGlobalTransform);
 		}
 	}
 }
@@ -581,9 +743,10 @@ void FChainFK::PutCurrentTransformsInRefPose(
 void FChainEncoderFK::EncodePose(
 	const FRetargetSkeleton& SourceSkeleton,
 	const TArray<int32>& SourceBoneIndices,
-    const TArray<FTransform> &InSourceGlobalPose)
+    const TArray<FTransform> &InSourceGlobalPose,
+	FChainFKState& State) const
 {
-	//check(SourceBoneIndices.Num() == CurrentGlobalTransforms.Num());
+	//check(SourceBoneIndices.Num() == State.CurrentGlobalTransforms.Num());
 
 #ifdef DEBUG_POSE_LOG
 	printf("encode\n");
@@ -608,33 +771,101 @@ void FChainEncoderFK::EncodePose(
 #endif 
 	
 	// copy the global input pose for the chain
+	// the retarget poses were checked for scale at init, the animated source is checked here every frame
+	// and a scaled chain or parent goes through FTransform math for this frame
+	State.bDualQuatPose = bUseDualQuat;
 	for (int32 ChainIndex=0; ChainIndex<SourceBoneIndices.size(); ++ChainIndex)
 	{
 		const int32 BoneIndex = SourceBoneIndices[ChainIndex];
-		CurrentGlobalTransforms[ChainIndex] = InSourceGlobalPose[BoneIndex];
+		State.CurrentGlobalTransforms[ChainIndex] = InSourceGlobalPose[BoneIndex];
+		State.bDualQuatPose = State.bDualQuatPose && HasUnitScale(InSourceGlobalPose[BoneIndex]);
+	}
+	if (ChainParentBoneIndex != INDEX_NONE)
+	{
+		State.bDualQuatPose = State.bDualQuatPose && HasUnitScale(InSourceGlobalPose[ChainParentBoneIndex]);
 	}
 
-	CurrentLocalTransforms.resize(SourceBoneIndices.size());
-	FillTransformsWithLocalSpaceOfChain(SourceSkeleton, InSourceGlobalPose, SourceBoneIndices, CurrentLocalTransforms);
+	// no local space pass, TransformCurrentChainTransforms() moves the globals under the new parent directly
+	// and only falls back to local transforms for a non uniformly scaled parent
+	if (State.bDualQuatPose)
+	{
+		for (int32 ChainIndex=0; ChainIndex<SourceBoneIndices.size(); ++ChainIndex)
+		{
+			TransformKernel::ToDualQuat(State.CurrentGlobalDualQuats[ChainIndex], State.CurrentGlobalTransforms[ChainIndex]);
+		}
+	}
 
 	if (ChainParentBoneIndex != INDEX_NONE)
 	{
-		ChainParentCurrentGlobalTransform = InSourceGlobalPose[ChainParentBoneIndex];
+		State.ChainParentCurrentGlobalTransform = InSourceGlobalPose[ChainParentBoneIndex];
 	}
 }
 
-void FChainEncoderFK::TransformCurrentChainTransforms(const FTransform& NewParentTransform)
+// scales read from float data are rarely exactly uniform, a few ulps off still re-parents the globals directly
+static bool HasUniformPositiveScale(const FTransform& Transform)
+{
+	const FVector& Scale = Transform.Scale3D;
+	const float Tolerance = 1.e-6f * std::abs(Scale.x);
+	return Scale.x > 0.0f && IsNearlyEqual(Scale.x, Scale.y, Tolerance) && IsNearlyEqual(Scale.x, Scale.z, Tolerance);
+}
+
+void FChainEncoderFK::TransformCurrentChainTransforms(const FTransform& NewParentTransform, FChainFKState& State) const
 {
-	for (int32 ChainIndex=0; ChainIndex<CurrentGlobalTransforms.size(); ++ChainIndex)
+	// every chain bone is a child of the previous one, so rebuilding the chain from its locals under the new parent,
+	// global = local * parent global, comes down to global * inverse(old parent) * new parent for each bone on its own
+	// the new parent is a target bone, scaled when an earlier chain passed on source scale
+	State.bDualQuatPose = State.bDualQuatPose && HasUnitScale(NewParentTransform);
+	if (State.bDualQuatPose)
+	{
+		FDualQuat ParentDeltaDualQuat;
+		TransformKernel::ToDualQuat(ParentDeltaDualQuat, NewParentTransform);
+		if (ChainParentBoneIndex != INDEX_NONE)
+		{
+			FDualQuat OldParentDualQuat;
+			TransformKernel::ToDualQuat(OldParentDualQuat, State.ChainParentCurrentGlobalTransform);
+			TransformKernel::Multiply(ParentDeltaDualQuat, OldParentDualQuat.Inverse(), ParentDeltaDualQuat);
+		}
+		for (int32 ChainIndex=0; ChainIndex<State.CurrentGlobalDualQuats.size(); ++ChainIndex)
+		{
+			TransformKernel::Multiply(State.CurrentGlobalDualQuats[ChainIndex], State.CurrentGlobalDualQuats[ChainIndex], ParentDeltaDualQuat);
+			TransformKernel::ToTransform(State.CurrentGlobalTransforms[ChainIndex], State.CurrentGlobalDualQuats[ChainIndex]);
+		}
+		return;
+	}
+
+	// FTransform products only associate when the right hand side has uniform scale, so with a non uniformly scaled
+	// parent the chain is rebuilt from its local transforms, the globals still hold the source chain at this point
+	const bool bHasSourceParent = ChainParentBoneIndex != INDEX_NONE;
+	if (!HasUniformPositiveScale(NewParentTransform) || (bHasSourceParent && !HasUniformPositiveScale(State.ChainParentCurrentGlobalTransform)))
 	{
-		if (ChainIndex == 0)
+		for (int32 ChainIndex=0; ChainIndex<State.CurrentGlobalTransforms.size(); ++ChainIndex)
 		{
-			CurrentGlobalTransforms[ChainIndex] = CurrentLocalTransforms[ChainIndex] * NewParentTransform;
+			if (ChainIndex == 0 && !bHasSourceParent)
+			{
+				State.CurrentLocalTransforms[ChainIndex] = State.CurrentGlobalTransforms[ChainIndex];
+				continue;
+			}
+			const FTransform& ParentGlobalTransform = ChainIndex == 0 ? State.ChainParentCurrentGlobalTransform : State.CurrentGlobalTransforms[ChainIndex-1];
+			TransformKernel::Relative(State.CurrentLocalTransforms[ChainIndex], State.CurrentGlobalTransforms[ChainIndex], ParentGlobalTransform);
 		}
-		else
+		for (int32 ChainIndex=0; ChainIndex<State.CurrentGlobalTransforms.size(); ++ChainIndex)
 		{
-			CurrentGlobalTransforms[ChainIndex] = CurrentLocalTransforms[ChainIndex] * CurrentGlobalTransforms[ChainIndex-1];
+			const FTransform& ParentGlobalTransform = ChainIndex == 0 ? NewParentTransform : State.CurrentGlobalTransforms[ChainIndex-1];
+			TransformKernel::Multiply(State.CurrentGlobalTransforms[ChainIndex], State.CurrentLocalTransforms[ChainIndex], ParentGlobalTransform);
 		}
+		return;
+	}
+
+	FTransform ParentDelta = NewParentTransform;
+	if (bHasSourceParent)
+	{
+		FTransform InverseOldParent;
+		TransformKernel::Inverse(InverseOldParent, State.ChainParentCurrentGlobalTransform);
+		TransformKernel::Multiply(ParentDelta, InverseOldParent, NewParentTransform);
+	}
+	for (int32 ChainIndex=0; ChainIndex<State.CurrentGlobalTransforms.size(); ++ChainIndex)
+	{
+		TransformKernel::Multiply(State.CurrentGlobalTransforms[ChainIndex], State.CurrentGlobalTransforms[ChainIndex], ParentDelta);
 	}
 }
 
@@ -734,11 +965,13 @@ void FChainDecoderFK::DecodePose(
 	const FRootRetargeter& RootRetargeter,
 	const FTargetChainSettings& Settings,
 	const TArray<int32>& TargetBoneIndices,
-    FChainEncoderFK& SourceChain,
+    const FChainEncoderFK& SourceChain,
+	FChainFKState& SourceState,
+	FChainFKState& State,
     const FTargetSkeleton& TargetSkeleton,
-    TArray<FTransform> &InOutGlobalPose)
+    TArray<FTransform> &InOutGlobalPose) const
 {
-	//check(TargetBoneIndices.Num() == CurrentGlobalTransforms.Num());
+	//check(TargetBoneIndices.Num() == State.CurrentGlobalTransforms.Num());
 	//check(TargetBoneIndices.Num() == Params.Num());
 
 	// Before setting this chain pose, we need to ensure that any
@@ -753,29 +986,28 @@ void FChainDecoderFK::DecodePose(
 	// transform entire source chain from it's root to match target's current root orientation (maintaining offset from retarget pose)
 	// this ensures children are retargeted in a "local" manner free from skewing that will happen if source and target
 	// become misaligned as can happen if parent chains were not retargeted
-	FTransform SourceChainParentInitialDelta = SourceChain.ChainParentInitialGlobalTransform.GetRelativeTransform(ChainParentInitialGlobalTransform);
 	FTransform TargetChainParentCurrentGlobalTransform = ChainParentBoneIndex == INDEX_NONE ? FTransform::Identity : InOutGlobalPose[ChainParentBoneIndex]; 
 	FTransform SourceChainParentTransform = SourceChainParentInitialDelta * TargetChainParentCurrentGlobalTransform;
 
 	// apply delta to the source chain's current transforms before transferring rotations to the target
-	SourceChain.TransformCurrentChainTransforms(SourceChainParentTransform);
+	SourceChain.TransformCurrentChainTransforms(SourceChainParentTransform, SourceState);
 
 	// if FK retargeting has been disabled for this chain, then simply set it to the retarget pose
 	if (!Settings.FK.EnableFK)
 	{
 		// put the chain in the global ref pose (globally rotated by parent bone in it's currently retargeted state)
-		PutCurrentTransformsInRefPose(TargetBoneIndices, TargetSkeleton, InOutGlobalPose);
+		PutCurrentTransformsInRefPose(TargetBoneIndices, TargetSkeleton, InOutGlobalPose, State);
 		
 		for (int32 ChainIndex=0; ChainIndex<TargetBoneIndices.size(); ++ChainIndex)
 		{
 			const int32 BoneIndex = TargetBoneIndices[ChainIndex];
-			InOutGlobalPose[BoneIndex] = CurrentGlobalTransforms[ChainIndex];
+			InOutGlobalPose[BoneIndex] = State.CurrentGlobalTransforms[ChainIndex];
 		}
 
 		return;
 	}
 
-	const int32 NumBonesInSourceChain = static_cast<int32>(SourceChain.CurrentGlobalTransforms.size());
+	const int32 NumBonesInSourceChain = static_cast<int32>(SourceState.CurrentGlobalTransforms.size());
 	const int32 NumBonesInTargetChain = static_cast<int32>(TargetBoneIndices.size());
 	const int32 TargetStartIndex = std::max(0, NumBonesInTargetChain - NumBonesInSourceChain);
 	const int32 SourceStartIndex = std::max(0,NumBonesInSourceChain - NumBonesInTargetChain);
@@ -794,29 +1026,23 @@ void FChainDecoderFK::DecodePose(
 			case ERetargetRotationMode::Interpolated:
 			{
 				// get the initial and current transform of source chain at param
-				// this is the interpolated transform along the chain
-				const float Param = Params[ChainIndex];
-					
-				SourceCurrentTransform = GetTransformAtParam(
-					SourceChain.CurrentGlobalTransforms,
-					SourceChain.Params,
-					Param);
-
-				SourceInitialTransform = GetTransformAtParam(
-					SourceChain.InitialGlobalTransforms,
-					SourceChain.Params,
-					Param);
+				// this is the interpolated transform along the chain, the initial one never changes
+				const FChainParamBracket& Bracket = SourceBrackets[ChainIndex];
+				SourceCurrentTransform = SourceState.bDualQuatPose
+					? GetDualQuatAtBracket(SourceState.CurrentGlobalDualQuats, Bracket)
+					: GetTransformAtBracket(SourceState.CurrentGlobalTransforms, Bracket);
+				SourceInitialTransform = SourceInitialTransformsAtParam[ChainIndex];
 			}
 			break;
 			case ERetargetRotationMode::OneToOne:
 			{
 				if (ChainIndex < NumBonesInSourceChain)
 				{
-					SourceCurrentTransform = SourceChain.CurrentGlobalTransforms[ChainIndex];
+					SourceCurrentTransform = SourceState.CurrentGlobalTransforms[ChainIndex];
 					SourceInitialTransform = SourceChain.InitialGlobalTransforms[ChainIndex];
 				}else
 				{
-					SourceCurrentTransform = SourceChain.CurrentGlobalTransforms.back();
+					SourceCurrentTransform = SourceState.CurrentGlobalTransforms.back();
 					SourceInitialTransform = SourceChain.InitialGlobalTransforms.back();
 				}
 			}
@@ -831,7 +1057,7 @@ void FChainDecoderFK::DecodePose(
 				else
 				{
 					const int32 SourceChainIndex = SourceStartIndex + (ChainIndex - TargetStartIndex);
-					SourceCurrentTransform = SourceChain.CurrentGlobalTransforms[SourceChainIndex];
+					SourceCurrentTransform = SourceState.CurrentGlobalTransforms[SourceChainIndex];
 					SourceInitialTransform = SourceChain.InitialGlobalTransforms[SourceChainIndex];
 				}
 			}
@@ -943,8 +1169,8 @@ void FChainDecoderFK::DecodePose(
 		const FVector OutScale = SourceCurrentScale + (TargetInitialScale - SourceInitialScale);
 		
 		// apply output transform
-		CurrentGlobalTransforms[ChainIndex] = FTransform(OutRotation, OutPosition, OutScale);
-		InOutGlobalPose[BoneIndex] = CurrentGlobalTransforms[ChainIndex];
+		State.CurrentGlobalTransforms[ChainIndex] = FTransform(OutRotation, OutPosition, OutScale);
+		InOutGlobalPose[BoneIndex] = State.CurrentGlobalTransforms[ChainIndex];
 
 		#ifdef DEBUG_POSE_LOG_CHAINFK
 		if (ChainIndex == 0) {
@@ -960,8 +1186,7 @@ void FChainDecoderFK::DecodePose(
 	// (skipped if the alphas are not near 1.0)
 	if (!IsNearlyEqual(Settings.FK.RotationAlpha, 1.0f) || !IsNearlyEqual(Settings.FK.TranslationAlpha, 1.0f))
 	{
-		TArray<FTransform> NewLocalTransforms;
-		NewLocalTransforms.resize(InitialLocalTransforms.size());
+		TArray<FTransform>& NewLocalTransforms = State.CurrentLocalTransforms;
 		FillTransformsWithLocalSpaceOfChain(TargetSkeleton, InOutGlobalPose, TargetBoneIndices, NewLocalTransforms);
 
 		for (int32 ChainIndex=0; ChainIndex<InitialLocalTransforms.size(); ++ChainIndex)
@@ -970,13 +1195,13 @@ void FChainDecoderFK::DecodePose(
 			FTransform& NewLocalTransform = NewLocalTransforms[ChainIndex];
 			const FTransform& RefPoseLocalTransform = InitialLocalTransforms[ChainIndex];
 			NewLocalTransform.SetTranslation(FVector::lerp(RefPoseLocalTransform.GetTranslation(), NewLocalTransform.GetTranslation(), Settings.FK.TranslationAlpha));
-			NewLocalTransform.SetRotation(FQuat::FastLerp(RefPoseLocalTransform.GetRotation(), NewLocalTransform.GetRotation(), Settings.FK.RotationAlpha).GetNormalized());
+			TransformKernel::NLerp(NewLocalTransform.Rotation, RefPoseLocalTransform.Rotation, NewLocalTransform.Rotation, Settings.FK.RotationAlpha);
 
 			// put blended transforms back in global space and store in final output pose
 			const int32 BoneIndex = TargetBoneIndices[ChainIndex];
 			const int32 ParentIndex = TargetSkeleton.ParentIndices[BoneIndex];
 			const FTransform& ParentGlobalTransform = ParentIndex == INDEX_NONE ? FTransform::Identity : InOutGlobalPose[ParentIndex];
-			InOutGlobalPose[BoneIndex] = NewLocalTransform * ParentGlobalTransform;
+			TransformKernel::Multiply(InOutGlobalPose[BoneIndex], NewLocalTransform, ParentGlobalTransform);
 		}
 	}
 }
@@ -1009,7 +1234,7 @@ void FChainDecoderFK::InitializeIntermediateParentIndices(
 
 void FChainDecoderFK::UpdateIntermediateParents(
 	const FTargetSkeleton& TargetSkeleton,
-	TArray<FTransform>& InOutGlobalPose)
+	TArray<FTransform>& InOutGlobalPose) const
 {
 	for (const int32& ParentIndex : IntermediateParentIndices)
 	{
@@ -1017,64 +1242,102 @@ void FChainDecoderFK::UpdateIntermediateParents(
 	}
 }
 
-FTransform FChainDecoderFK::GetTransformAtParam(
+void FChainDecoderFK::InitializeSourceBrackets(const FChainEncoderFK& SourceChain)
+{
+	const TArray<float>& SourceParams = SourceChain.Params;
+	SourceBrackets.resize(Params.size());
+	SourceInitialTransformsAtParam.resize(Params.size());
+	for (int32 ChainIndex=0; ChainIndex<Params.size(); ++ChainIndex)
+	{
+		const float Param = Params[ChainIndex];
+		FChainParamBracket& Bracket = SourceBrackets[ChainIndex];
+		Bracket = FChainParamBracket();
+		if (SourceParams.size() == 1 || Param < KINDA_SMALL_NUMBER)
+		{
+			Bracket.PrevIndex = 0;
+		}
+		else if (Param > 1.0f - KINDA_SMALL_NUMBER)
+		{
+			Bracket.PrevIndex = (int32)SourceParams.size() - 1;
+		}
+		else
+		{
+			Bracket.PrevIndex = INDEX_NONE;
+			for (int32 SourceIndex=1; SourceIndex<SourceParams.size(); ++SourceIndex)
+			{
+				const float CurrentParam = SourceParams[SourceIndex];
+				if (CurrentParam <= Param)
+				{
+					continue;
+				}
+
+				const float PrevParam = SourceParams[SourceIndex-1];
+				Bracket.PrevIndex = SourceIndex - 1;
+				Bracket.NextIndex = SourceIndex;
+				Bracket.Alpha = (Param - PrevParam) / (CurrentParam - PrevParam);
+				break;
+			}
+			if (Bracket.PrevIndex == INDEX_NONE)
+			{
+				checkNoEntry();
+			}
+		}
+
+		SourceInitialTransformsAtParam[ChainIndex] = SourceChain.bUseDualQuat
+			? GetDualQuatAtBracket(SourceChain.InitialGlobalDualQuats, Bracket)
+			: GetTransformAtBracket(SourceChain.InitialGlobalTransforms, Bracket);
+	}
+
+	SourceChainParentInitialDelta = SourceChain.ChainParentInitialGlobalTransform.GetRelativeTransform(ChainParentInitialGlobalTransform);
+}
+
+FTransform FChainDecoderFK::GetTransformAtBracket(
 	const TArray<FTransform>& Transforms,
-	const TArray<float>& InParams,
-	const float& Param) const
+	const FChainParamBracket& Bracket)
 {
-	if (InParams.size() == 1)
+	if (Bracket.PrevIndex == INDEX_NONE)
 	{
-		#ifdef DEBUG_POSE_LOG_CHAINFK
-		printf("get front chain:%d\n", 0);
-		#endif
-		return Transforms[0];
+		return FTransform::Identity;
 	}
-	
-	if (Param < KINDA_SMALL_NUMBER)
+	if (Bracket.NextIndex == INDEX_NONE)
 	{
-		#ifdef DEBUG_POSE_LOG_CHAINFK
-		printf("get front chain:%d\n", 0);
-		#endif
-		return Transforms[0];
+		return Transforms[Bracket.PrevIndex];
 	}
 
-	if (Param > 1.0f - KINDA_SMALL_NUMBER)
+	const FTransform& Prev = Transforms[Bracket.PrevIndex];
+	const FTransform& Next = Transforms[Bracket.NextIndex];
+	const FVector Position = FVector::lerp(Prev.GetTranslation(), Next.GetTranslation(), Bracket.Alpha);
+	FQuat Rotation;
+	TransformKernel::NLerp(Rotation, Prev.Rotation, Next.Rotation, Bracket.Alpha);
+	const FVector Scale = FVector::lerp(Prev.GetScale3D(), Next.GetScale3D(), Bracket.Alpha);
+
+	#ifdef DEBUG_POSE_LOG_CHAINFK
+	printf("get blend chain:%d %d %.2f t:(%.2f %.2f %.2f) r.xyzw(%.2f %.2f %.2f %.2f)\n", 
+			Bracket.PrevIndex, Bracket.NextIndex, Bracket.Alpha,
+			Position.x, Position.y, Position.z,
+			Rotation.x, Rotation.y, Rotation.z, Rotation.w
+		);
+	#endif
+	return FTransform(Rotation,Position, Scale);
+}
+
+FTransform FChainDecoderFK::GetDualQuatAtBracket(
+	const TArray<FDualQuat>& DualQuats,
+	const FChainParamBracket& Bracket)
+{
+	FDualQuat Result = FDualQuat::Identity;
+	if (Bracket.PrevIndex != INDEX_NONE && Bracket.NextIndex == INDEX_NONE)
 	{
-		#ifdef DEBUG_POSE_LOG_CHAINFK
-		printf("get back chain:%d\n", Transforms.size()-1);
-		#endif
-		return Transforms.back();
+		Result = DualQuats[Bracket.PrevIndex];
 	}
-
-	for (int32 ChainIndex=1; ChainIndex<InParams.size(); ++ChainIndex)
+	else if (Bracket.PrevIndex != INDEX_NONE)
 	{
-		const float CurrentParam = InParams[ChainIndex];
-		if (CurrentParam <= Param)
-		{
-			continue;
-		}
-		
-		const float PrevParam = InParams[ChainIndex-1];
-		const float PercentBetweenParams = (Param - PrevParam) / (CurrentParam - PrevParam);
-		const FTransform& Prev = Transforms[ChainIndex-1];
-		const FTransform& Next = Transforms[ChainIndex];
-		const FVector Position = FVector::lerp(Prev.GetTranslation(), Next.GetTranslation(), PercentBetweenParams);
-		FQuat Rotation = FQuat::FastLerp(Prev.GetRotation(), Next.GetRotation(), PercentBetweenParams).GetNormalized();
-		const FVector Scale = FVector::lerp(Prev.GetScale3D(), Next.GetScale3D(), PercentBetweenParams);
-		
-		#ifdef DEBUG_POSE_LOG_CHAINFK
-		//Rotation = FQuat::Identity;
-		printf("get blend chain:%d %d %.2f t:(%.2f %.2f %.2f) r.xyzw(%.2f %.2f %.2f %.2f)\n", 
-				ChainIndex-1, ChainIndex, PercentBetweenParams,
-				Position.x, Position.y, Position.z,
-				Rotation.x, Rotation.y, Rotation.z, Rotation.w
-			);
-		#endif
-		return FTransform(Rotation,Position, Scale);
+		TransformKernel::NLerp(Result, DualQuats[Bracket.PrevIndex], DualQuats[Bracket.NextIndex], Bracket.Alpha);
 	}
 
-	checkNoEntry();
-	return FTransform::Identity;
+	FTransform Transform;
+	TransformKernel::ToTransform(Transform, Result);
+	return Transform;
 }
 
 
@@ -1217,6 +1480,8 @@ bool FRetargetChainPairFK::Initialize(
 		return false;
 	}
 
+	FKDecoder.InitializeSourceBrackets(FKEncoder);
+
 	// initialize the pole vector matcher for this chain
 	// const bool bPoleVectorMatcherInitialized = PoleVectorMatcher.Initialize(
 	// 	SourceBoneIndices,
@@ -1358,27 +1623,27 @@ void FRootRetargeter::Reset()
 	Target = FRootTarget();
 }
 
-void FRootRetargeter::EncodePose(const TArray<FTransform>& SourceGlobalPose)
+void FRootRetargeter::EncodePose(const TArray<FTransform>& SourceGlobalPose, FRootRetargeterState& State) const
 {
 	const FTransform& SourceTransform = SourceGlobalPose[Source.BoneIndex];
-	Source.CurrentPosition = SourceTransform.GetTranslation();
-	Source.CurrentPositionNormalized = Source.CurrentPosition * Source.InitialHeightInverse;
-	Source.CurrentRotation = SourceTransform.GetRotation();	
+	State.CurrentPosition = SourceTransform.GetTranslation();
+	State.CurrentPositionNormalized = State.CurrentPosition * Source.InitialHeightInverse;
+	State.CurrentRotation = SourceTransform.GetRotation();	
 
 	#ifdef DEBUG_POSE_LOG_ROOT
 	printf("root encode: t(%.2f %.2f %.2f) inverseHeight:%.2f\n", 
-		Source.CurrentPosition.x, Source.CurrentPosition.y, Source.CurrentPosition.z, Source.InitialHeightInverse
+		State.CurrentPosition.x, State.CurrentPosition.y, State.CurrentPosition.z, Source.InitialHeightInverse
 	);
 	#endif
 }
 
-void FRootRetargeter::DecodePose(TArray<FTransform>& OutTargetGlobalPose)
+void FRootRetargeter::DecodePose(FRootRetargeterState& State, TArray<FTransform>& OutTargetGlobalPose) const
 {
 	// retarget position
 	FVector Position;
 	{
 		// generate basic retarget root position by scaling the normalized position by root height
-		const FVector RetargetedPosition = Source.CurrentPositionNormalized * Target.InitialHeight;
+		const FVector RetargetedPosition = State.CurrentPositionNormalized * Target.InitialHeight;
 
 		#ifdef DEBUG_POSE_LOG_ROOT
 		printf("root decode RetargetedPosition: t(%.2f %.2f %.2f) height:%.2f\n", 
@@ -1387,7 +1652,7 @@ void FRootRetargeter::DecodePose(TArray<FTransform>& OutTargetGlobalPose)
 		#endif
 		
 		// blend the retarget root position towards the source retarget root position
-		Position = FVector::lerp(RetargetedPosition, Source.CurrentPosition, Settings.BlendToSource*Settings.BlendToSourceWeights);
+		Position = FVector::lerp(RetargetedPosition, State.CurrentPosition, Settings.BlendToSource*Settings.BlendToSourceWeights);
 
 		// apply vertical / horizontal scaling of motion
 		FVector ScaledRetargetedPosition = Position;
@@ -1402,14 +1667,14 @@ void FRootRetargeter::DecodePose(TArray<FTransform>& OutTargetGlobalPose)
 		Position = FVector::lerp(Target.InitialPosition, Position, Settings.TranslationAlpha);
 
 		// record the delta created by all the modifications made to the root translation
-		Target.RootTranslationDelta = Position - RetargetedPosition;
+		State.RootTranslationDelta = Position - RetargetedPosition;
 	}
 
 	// retarget rotation
 	FQuat Rotation;
 	{
 		// calc offset between initial source/target root rotations
-		const FQuat RotationDelta = Source.CurrentRotation * Source.InitialRotation.Inverse();
+		const FQuat RotationDelta = State.CurrentRotation * Source.InitialRotation.Inverse();
 		// add retarget pose delta to the current source rotation
 		const FQuat RetargetedRotation = RotationDelta * Target.InitialRotation;
 
@@ -1417,11 +1682,10 @@ void FRootRetargeter::DecodePose(TArray<FTransform>& OutTargetGlobalPose)
 		Rotation = RetargetedRotation * Settings.RotationOffset.Quaternion();
 
 		// blend with alpha
-		Rotation = FQuat::FastLerp(Target.InitialRotation, Rotation, Settings.RotationAlpha);
-		Rotation.Normalize();
+		TransformKernel::NLerp(Rotation, Target.InitialRotation, Rotation, Settings.RotationAlpha);
 
 		// record the delta created by all the modifications made to the root rotation
-		Target.RootRotationDelta = RetargetedRotation * Target.InitialRotation.Inverse();
+		State.RootRotationDelta = RetargetedRotation * Target.InitialRotation.Inverse();
 	}
 
 	// apply to target
@@ -1437,20 +1701,119 @@ UIKRetargetProcessor::UIKRetargetProcessor()
 {
 }
 
+void UIKRetargetProcessor::Initialize(
+		USkeleton* InSourceSkeleton,
+		USkeleton* InTargetSkeleton,
+		UIKRetargeter* InRetargeterAsset,
+		const bool bSuppressWarnings)
+{
+	// a new plan rather than re-initializing the old one in place, other contexts may still be running it
+	std::shared_ptr<FRetargetPlan> NewPlan = std::make_shared<FRetargetPlan>();
+	NewPlan->Initialize(InSourceSkeleton, InTargetSkeleton, InRetargeterAsset, Log);
+	Initialize(NewPlan);
+}
+
+void UIKRetargetProcessor::Initialize(std::shared_ptr<const FRetargetPlan> InPlan)
+{
+	Plan = std::move(InPlan);
+	Context.Initialize(Plan);
+}
+
+TArray<FTransform>& UIKRetargetProcessor::RunRetargeter(
+	const TArray<FTransform>& InSourceGlobalPose,
+	const std::unordered_map<FName, float>& SpeedValuesFromCurves,
+	const float DeltaTime)
+{
+	return Plan->RunRetargeter(Context, InSourceGlobalPose, SpeedValuesFromCurves, DeltaTime);
+}
+
+void UIKRetargetProcessor::RunRetargeter(
+	const FPoseSoA& InSourceGlobalPose,
+	FPoseSoA& OutTargetGlobalPose,
+	const std::unordered_map<FName, float>& SpeedValuesFromCurves,
+	const float DeltaTime)
+{
+	Plan->RunRetargeter(Context, InSourceGlobalPose, OutTargetGlobalPose, SpeedValuesFromCurves, DeltaTime);
+}
+
+void UIKRetargetProcessor::RunRetargeter(
+	const TArray<FTransform>& InSourceGlobalPose,
+	TArray<FTransform>& OutTargetGlobalPose,
+	const std::unordered_map<FName, float>& SpeedValuesFromCurves,
+	const float DeltaTime,
+	const bool bReuseOutputPose)
+{
+	Plan->RunRetargeter(Context, InSourceGlobalPose, OutTargetGlobalPose, SpeedValuesFromCurves, DeltaTime, bReuseOutputPose);
+}
+
+void UIKRetargetProcessor::RunRetargeterBatch(
+	const FTransform* InSourceGlobalPoses,
+	const int32 NumFrames,
+	FTransform* OutTargetGlobalPoses,
+	const std::unordered_map<FName, float>& SpeedValuesFromCurves,
+	const float DeltaTime)
+{
+	Plan->RunRetargeterBatch(Context, InSourceGlobalPoses, NumFrames, OutTargetGlobalPoses, SpeedValuesFromCurves, DeltaTime);
+}
+
+bool UIKRetargetProcessor::InitializeBoneMask(
+	const TArray<FName>& ChainNames,
+	const TArray<FName>& BoneNames,
+	FRetargetBoneMask& OutMask)
+{
+	return Plan->InitializeBoneMask(ChainNames, BoneNames, OutMask, Log);
+}
+
+void UIKRetargetProcessor::RunRetargeter(
+	const FRetargetBoneMask& Mask,
+	const TArray<FTransform>& InSourceGlobalPose,
+	TArray<FTransform>& OutMaskedGlobalPose,
+	const std::unordered_map<FName, float>& SpeedValuesFromCurves,
+	const float DeltaTime)
+{
+	Plan->RunRetargeter(Context, Mask, InSourceGlobalPose, OutMaskedGlobalPose, SpeedValuesFromCurves, DeltaTime);
+}
+
+// MARK: - context
+
+void FRetargetContext::Initialize(std::shared_ptr<const FRetargetPlan> InPlan)
+{
+	Plan = std::move(InPlan);
+	SourceChainsFK.resize(Plan->ChainPairsFK.size());
+	TargetChainsFK.resize(Plan->ChainPairsFK.size());
+	for (int32 ChainIndex=0; ChainIndex<Plan->ChainPairsFK.size(); ++ChainIndex)
+	{
+		Plan->ChainPairsFK[ChainIndex].FKEncoder.InitializeState(SourceChainsFK[ChainIndex]);
+		Plan->ChainPairsFK[ChainIndex].FKDecoder.InitializeState(TargetChainsFK[ChainIndex]);
+	}
+
+	Root = FRootRetargeterState();
+	OutputGlobalPose = Plan->TargetSkeleton.RetargetGlobalPose;
+	bNeedsFullUpdate = true;
+	for (FBatchFrame& BatchFrame : BatchFrames)
+	{
+		BatchFrame.bNeedsFullUpdate = true;
+	}
+}
+
 // MARK: - init
 /* #region MARK: -init */
 
-void UIKRetargetProcessor::Initialize(
+bool FRetargetPlan::Initialize(
 		USkeleton* InSourceSkeleton,
 		USkeleton* InTargetSkeleton,
 		UIKRetargeter* InRetargeterAsset,
-		const bool bSuppressWarnings)
+		FIKRigLogger& Log)
 {
 	// reset all initialized flags
 	bIsInitialized = false;
 	bRootsInitialized = false;
 	bAtLeastOneValidBoneChainPair = false;
 	bIKRigInitialized = false;
+	bDualQuatPoses = false;
+	bRunRoot = false;
+	bRunFK = false;
+	ChainGraphFK.Reset();
 	
 	// record source asset
 	RetargeterAsset = InRetargeterAsset;
@@ -1464,19 +1827,19 @@ void UIKRetargetProcessor::Initialize(
 	// check prerequisite assets
 	if (!InSourceSkeleton) {
 		Log.LogError("MissingSourceSkeleton");
-		return;
+		return false;
 	}
 	if (!InTargetSkeleton) {
 		Log.LogError("MissingTargetSkeleton");
-		return;
+		return false;
 	}
 	if (!SourceIKRig) {
 		Log.LogError("MissingSourceIKRig");
-		return;
+		return false;
 	}
 	if (!TargetIKRig) {
 		Log.LogError("MissingTargetIKRig");
-		return;
+		return false;
 	}
 	
 
@@ -1501,15 +1864,24 @@ void UIKRetargetProcessor::Initialize(
 		RetargetPose,//RetargeterAsset->GetCurrentRetargetPose(ERetargetSourceOrTarget::Target),
 		TargetIKRig->GetRetargetRoot());
 
+	// every retarget pass walks the hierarchy parent before child, a skeleton that can't be sorted can't run
+	if (SourceSkeleton.HierarchyError != EHierarchyError::None || TargetSkeleton.HierarchyError != EHierarchyError::None)
+	{
+		Log.LogError("InvalidHierarchy, source: %s, target: %s",
+			HierarchyErrorToString(SourceSkeleton.HierarchyError),
+			HierarchyErrorToString(TargetSkeleton.HierarchyError));
+		return false;
+	}
+
 	// initialize roots
-	bRootsInitialized = InitializeRoots();
+	bRootsInitialized = InitializeRoots(Log);
 	if (!bRootsInitialized) {
 		bIsInitialized = false;
-		return;
+		return false;
 	}
 
 	// initialize pairs of bone chains
-	bAtLeastOneValidBoneChainPair = InitializeBoneChainPairs();
+	bAtLeastOneValidBoneChainPair = InitializeBoneChainPairs(Log);
 	if (!bAtLeastOneValidBoneChainPair)
 	{
 		// couldn't match up any BoneChain pairs, no limb retargeting possible
@@ -1518,8 +1890,43 @@ void UIKRetargetProcessor::Initialize(
 		// 	SourceSkeletalMesh->GetName(), TargetSkeletalMesh->GetName());
 	}
 
+	// dual quaternion mode drops scale, so it is only taken when both retarget poses have none
+	if (GlobalSettings.bDualQuatPoses)
+	{
+		if (SourceSkeleton.HasUnitScale() && TargetSkeleton.HasUnitScale())
+		{
+			bDualQuatPoses = true;
+			TargetSkeleton.InitializeDualQuats();
+			for (FRetargetChainPairFK& ChainPair : ChainPairsFK)
+			{
+				ChainPair.FKEncoder.EnableDualQuat();
+				ChainPair.FKDecoder.EnableDualQuat();
+				ChainPair.FKDecoder.InitializeSourceBrackets(ChainPair.FKEncoder);
+			}
+		}
+		else
+		{
+			Log.LogWarning("DualQuatPosesNeedUnitScale, retarget pose has scaled bones, falling back to FTransform math.", "");
+		}
+	}
+
+	// level order hierarchy updates change how the work is split, not the result
+	if (GlobalSettings.bLevelHierarchyUpdates)
+	{
+		for (FRetargetSkeleton* RetargetSkeleton : {static_cast<FRetargetSkeleton*>(&SourceSkeleton), static_cast<FRetargetSkeleton*>(&TargetSkeleton)})
+		{
+			RetargetSkeleton->bUpdateByLevel = true;
+			RetargetSkeleton->ParallelLevelMinBones = GlobalSettings.ParallelLevelMinBones;
+		}
+	}
+
+	if (GlobalSettings.bParallelFKChains)
+	{
+		InitializeChainGraphFK();
+	}
+
 	// initialize the IKRigProcessor for doing IK decoding
-	bIKRigInitialized = InitializeIKRig(this, InTargetSkeleton);
+	bIKRigInitialized = InitializeIKRig(nullptr, InTargetSkeleton);
 	if (!bIKRigInitialized)
 	{
 		// couldn't initialize the IK Rig, we don't disable the retargeter in this case, just warn the user
@@ -1537,13 +1944,19 @@ void UIKRetargetProcessor::Initialize(
 		// 		SourceSkeleton->GetName(), TargetSkeleton->GetName());
 	}
 
+	// the stages never change after this, so neither do the bones they can move
+	bRunRoot = GlobalSettings.bEnableRoot && bRootsInitialized;
+	bRunFK = GlobalSettings.bEnableFK && bAtLeastOneValidBoneChainPair;
+	TargetSkeleton.InitializeDirtyBones(bRunRoot, bRunFK, RootRetargeter.Target.BoneIndex);
+
 	// copy the initial settings from the asset
 	//ApplySettingsFromAsset();
 	
 	bIsInitialized = true;
+	return true;
 }
 
-bool UIKRetargetProcessor::InitializeRoots()
+bool FRetargetPlan::InitializeRoots(FIKRigLogger& Log)
 {
 	// reset root data
 	RootRetargeter.Reset();
@@ -1575,7 +1988,7 @@ bool UIKRetargetProcessor::InitializeRoots()
 	return bRootEncoderInit && bRootDecoderInit;
 }
 
-bool UIKRetargetProcessor::InitializeBoneChainPairs()
+bool FRetargetPlan::InitializeBoneChainPairs(FIKRigLogger& Log)
 {
 	ChainPairsFK.clear();
 	ChainPairsIK.clear();
@@ -1658,7 +2071,7 @@ bool UIKRetargetProcessor::InitializeBoneChainPairs()
 		if (IndexA == IndexB)
 		{
 			// fallback to sorting alphabetically
-			return A.TargetBoneChainName.compare(B.TargetBoneChainName) < 0; // bugfix: <= -> <
+			return A.TargetBoneChainName.ToString().compare(B.TargetBoneChainName.ToString()) < 0; // bugfix: <= -> <
 		}
 		return IndexA < IndexB;
 	};
@@ -1694,12 +2107,216 @@ bool UIKRetargetProcessor::InitializeBoneChainPairs()
 	return !(ChainPairsIK.empty() && ChainPairsFK.empty());
 }
 
-bool UIKRetargetProcessor::InitializeIKRig(UObject* Outer, const USkeleton* InSkeleton)
+void FRetargetPlan::InitializeChainGraphFK()
+{
+	// a chain writes its bones and intermediate parents and reads their parents in the target pose,
+	// it waits for every earlier chain that writes what it touches or reads what it writes,
+	// so each target bone sees the same writes in the same order as the serial run
+	const int32 NumBones = static_cast<int32>(TargetSkeleton.ParentIndices.size());
+	TArray<int32> LastWriter(NumBones, INDEX_NONE);
+	TArray<TArray<int32>> ReadersSinceWrite(NumBones);
+	TArray<TArray<int32>> Dependencies(ChainPairsFK.size());
+	TArray<int32> Written;
+	TArray<int32> Read;
+	for (int32 ChainIndex=0; ChainIndex<ChainPairsFK.size(); ++ChainIndex)
+	{
+		const FRetargetChainPairFK& ChainPair = ChainPairsFK[ChainIndex];
+		Written = ChainPair.FKDecoder.GetIntermediateParentIndices();
+		Written.insert(Written.end(), ChainPair.TargetBoneIndices.begin(), ChainPair.TargetBoneIndices.end());
+		Read.clear();
+		for (const int32 BoneIndex : Written)
+		{
+			const int32 ParentIndex = TargetSkeleton.ParentIndices[BoneIndex];
+			if (ParentIndex != INDEX_NONE)
+			{
+				Read.push_back(ParentIndex);
+			}
+		}
+
+		TArray<int32>& ChainDependencies = Dependencies[ChainIndex];
+		for (const int32 BoneIndex : Read)
+		{
+			if (LastWriter[BoneIndex] != INDEX_NONE)
+			{
+				ChainDependencies.push_back(LastWriter[BoneIndex]);
+			}
+		}
+		for (const int32 BoneIndex : Written)
+		{
+			if (LastWriter[BoneIndex] != INDEX_NONE)
+			{
+				ChainDependencies.push_back(LastWriter[BoneIndex]);
+			}
+			ChainDependencies.insert(ChainDependencies.end(), ReadersSinceWrite[BoneIndex].begin(), ReadersSinceWrite[BoneIndex].end());
+		}
+		std::sort(ChainDependencies.begin(), ChainDependencies.end());
+		ChainDependencies.erase(std::unique(ChainDependencies.begin(), ChainDependencies.end()), ChainDependencies.end());
+
+		for (const int32 BoneIndex : Read)
+		{
+			ReadersSinceWrite[BoneIndex].push_back(ChainIndex);
+		}
+		for (const int32 BoneIndex : Written)
+		{
+			LastWriter[BoneIndex] = ChainIndex;
+			ReadersSinceWrite[BoneIndex].clear();
+		}
+	}
+
+	ChainGraphFK.Initialize(Dependencies);
+}
+
+bool FRetargetPlan::InitializeIKRig(UObject* Outer, const USkeleton* InSkeleton)
 {
 	// TODO	
 	return true;
 }
 
+bool FRetargetPlan::InitializeBoneMask(
+	const TArray<FName>& ChainNames,
+	const TArray<FName>& BoneNames,
+	FRetargetBoneMask& OutMask,
+	FIKRigLogger& Log) const
+{
+	OutMask = FRetargetBoneMask();
+	if (!bIsInitialized)
+	{
+		Log.LogError("BoneMaskPlanNotInitialized");
+		return false;
+	}
+
+	const int32 NumBones = (int32)TargetSkeleton.BoneNames.size();
+	TArray<bool> IsBoneMasked(NumBones, false);
+	for (const FName& ChainName : ChainNames)
+	{
+		auto ChainPair = std::find_if(ChainPairsFK.begin(), ChainPairsFK.end(),
+			[&ChainName](const FRetargetChainPairFK& Pair) { return Pair.TargetBoneChainName == ChainName; });
+		if (ChainPair == ChainPairsFK.end())
+		{
+			Log.LogError("BoneMaskMissingChain, %s is not a mapped target chain", ChainName.c_str());
+			return false;
+		}
+		for (const int32 BoneIndex : ChainPair->TargetBoneIndices)
+		{
+			IsBoneMasked[BoneIndex] = true;
+		}
+	}
+	for (const FName& BoneName : BoneNames)
+	{
+		const int32 BoneIndex = TargetSkeleton.FindBoneIndexByName(BoneName);
+		if (BoneIndex == INDEX_NONE)
+		{
+			Log.LogError("BoneMaskMissingBone, %s is not in the target skeleton", BoneName.c_str());
+			return false;
+		}
+		IsBoneMasked[BoneIndex] = true;
+	}
+
+	// globals need every parent, children come after their parents so walking backwards closes the mask in one pass
+	for (int32 BoneIndex=NumBones-1; BoneIndex>=0; --BoneIndex)
+	{
+		const int32 ParentIndex = TargetSkeleton.ParentIndices[BoneIndex];
+		if (IsBoneMasked[BoneIndex] && ParentIndex != INDEX_NONE)
+		{
+			IsBoneMasked[ParentIndex] = true;
+		}
+	}
+
+	// a chain is decoded as a whole, so one masked bone brings in the rest of the chain,
+	// the added bones are below that one and the chain start, so their parents are masked already
+	for (int32 ChainIndex=0; ChainIndex<ChainPairsFK.size(); ++ChainIndex)
+	{
+		const TArray<int32>& TargetBoneIndices = ChainPairsFK[ChainIndex].TargetBoneIndices;
+		const bool bChainMasked = std::any_of(TargetBoneIndices.begin(), TargetBoneIndices.end(),
+			[&IsBoneMasked](const int32 BoneIndex) { return IsBoneMasked[BoneIndex]; });
+		if (!bChainMasked)
+		{
+			continue;
+		}
+		for (const int32 BoneIndex : TargetBoneIndices)
+		{
+			IsBoneMasked[BoneIndex] = true;
+		}
+		if (bRunFK)
+		{
+			OutMask.ChainPairsFK.push_back(ChainIndex);
+		}
+	}
+
+	const int32 RootBoneIndex = RootRetargeter.Target.BoneIndex;
+	OutMask.bRunRoot = bRunRoot && IsBoneMasked[RootBoneIndex];
+
+	// same analysis as FTargetSkeleton::InitializeDirtyBones, a bone nothing writes is updated from its parent
+	// even when it is in a chain, the masked run never falls back to a full update below the root
+	TArray<bool> IsBoneDirty(NumBones, false);
+	for (int32 BoneIndex=0; BoneIndex<NumBones; ++BoneIndex)
+	{
+		const bool bIsRoot = BoneIndex == RootBoneIndex;
+		const bool bIsWritten = bIsRoot ? bRunRoot : (bRunFK && TargetSkeleton.IsBoneRetargeted[BoneIndex]);
+		const int32 ParentIndex = TargetSkeleton.ParentIndices[BoneIndex];
+		IsBoneDirty[BoneIndex] = bIsWritten || (ParentIndex != INDEX_NONE && IsBoneDirty[ParentIndex]);
+
+		if (!IsBoneMasked[BoneIndex])
+		{
+			continue;
+		}
+		if (bIsWritten)
+		{
+			OutMask.DirtyRetargetedBoneIndices.push_back(BoneIndex);
+		}
+		else if (IsBoneDirty[BoneIndex])
+		{
+			OutMask.DirtyNonRetargetedBoneIndices.push_back(BoneIndex);
+		}
+	}
+
+	// source bones the encoders read: the root, every chain bone with its parent and the chain parent
+	TArray<bool> IsSourceBoneRead(SourceSkeleton.BoneNames.size(), false);
+	if (OutMask.bRunRoot)
+	{
+		IsSourceBoneRead[RootRetargeter.Source.BoneIndex] = true;
+	}
+	for (const int32 ChainIndex : OutMask.ChainPairsFK)
+	{
+		const FRetargetChainPairFK& ChainPair = ChainPairsFK[ChainIndex];
+		for (const int32 BoneIndex : ChainPair.SourceBoneIndices)
+		{
+			IsSourceBoneRead[BoneIndex] = true;
+			const int32 ParentIndex = SourceSkeleton.GetParentIndex(BoneIndex);
+			if (ParentIndex != INDEX_NONE)
+			{
+				IsSourceBoneRead[ParentIndex] = true;
+			}
+		}
+		if (ChainPair.FKEncoder.ChainParentBoneIndex != INDEX_NONE)
+		{
+			IsSourceBoneRead[ChainPair.FKEncoder.ChainParentBoneIndex] = true;
+		}
+	}
+	for (int32 BoneIndex=0; BoneIndex<IsSourceBoneRead.size(); ++BoneIndex)
+	{
+		if (IsSourceBoneRead[BoneIndex])
+		{
+			OutMask.SourceBoneIndices.push_back(BoneIndex);
+		}
+	}
+
+	// output in USkeleton order
+	const FBoneHierarchy& Hierarchy = TargetSkeleton.Hierarchy;
+	for (int32 FileIndex=0; FileIndex<NumBones; ++FileIndex)
+	{
+		const int32 BoneIndex = Hierarchy.FileToSorted[FileIndex];
+		if (IsBoneMasked[BoneIndex])
+		{
+			OutMask.BoneIndices.push_back(FileIndex);
+			OutMask.HierarchyBoneIndices.push_back(BoneIndex);
+		}
+	}
+
+	OutMask.Plan = this;
+	return true;
+}
+
 
 /* #endregion */
 
@@ -1708,92 +2325,425 @@ bool UIKRetargetProcessor::InitializeIKRig(UObject* Outer, const USkeleton* InSk
 // MARK: - run retarget
 /* #region MARK: -run retarget */
 
-TArray<FTransform>&  UIKRetargetProcessor::RunRetargeter(
+TArray<FTransform>& FRetargetPlan::RunRetargeter(
+	FRetargetContext& Context,
 	const TArray<FTransform>& InSourceGlobalPose,
 	const std::unordered_map<FName, float>& SpeedValuesFromCurves,
-	const float DeltaTime)
+	const float DeltaTime) const
+{
+	// the context's poses are only written by runs on it, after the first run they only need the moving bones
+	TArray<FTransform>& OutTargetGlobalPose = TargetSkeleton.Hierarchy.IsFileOrder() ? Context.OutputGlobalPose : Context.TargetGlobalPoseFileOrder;
+	RunRetargeter(Context, InSourceGlobalPose, OutTargetGlobalPose, SpeedValuesFromCurves, DeltaTime, true);
+	return OutTargetGlobalPose;
+}
+
+void FRetargetPlan::RunRetargeter(
+	FRetargetContext& Context,
+	const TArray<FTransform>& InSourceGlobalPose,
+	TArray<FTransform>& OutTargetGlobalPose,
+	const std::unordered_map<FName, float>& SpeedValuesFromCurves,
+	const float DeltaTime,
+	const bool bReuseOutputPose) const
 {
 	//check(bIsInitialized);
-		
-	// start from retarget pose
-	TargetSkeleton.OutputGlobalPose = TargetSkeleton.RetargetGlobalPose;
-	//return TargetSkeleton.OutputGlobalPose;
+
+	// bring the source pose to hierarchy order, the returned pose goes back to USkeleton order at the end
+	const TArray<FTransform>* SourceGlobalPosePtr = &InSourceGlobalPose;
+	if (!SourceSkeleton.Hierarchy.IsFileOrder())
+	{
+		SourceSkeleton.Hierarchy.ToSorted(InSourceGlobalPose, Context.SourceGlobalPoseSorted);
+		SourceGlobalPosePtr = &Context.SourceGlobalPoseSorted;
+	}
+	const TArray<FTransform>& SourceGlobalPose = *SourceGlobalPosePtr;
+
+	Context.PoseValidator.NextFrame();
+	ValidatePose(Context, SourceGlobalPose, SourceSkeleton, "source");
+
+	// only the caller knows the pose holds an earlier result, anything else may be stale everywhere
+	const size_t NumBones = TargetSkeleton.RetargetGlobalPose.size();
+	const bool bNewOutputPose = !bReuseOutputPose || OutTargetGlobalPose.size() != NumBones;
+	OutTargetGlobalPose.resize(NumBones);
+
+	// in USkeleton order the stages run straight on the caller's pose,
+	// otherwise on the context's pose in hierarchy order and the bones they move are copied over at the end
+	const bool bFileOrder = TargetSkeleton.Hierarchy.IsFileOrder();
+	TArray<FTransform>& OutputGlobalPose = bFileOrder ? OutTargetGlobalPose : Context.OutputGlobalPose;
+	const bool bFullUpdate = Context.bNeedsFullUpdate || (bFileOrder && bNewOutputPose);
+	Context.bNeedsFullUpdate = false;
+	ResetOutputPose(OutputGlobalPose, bFullUpdate);
 
 	// ROOT retargeting
-	if (GlobalSettings.bEnableRoot && bRootsInitialized)
+	if (bRunRoot)
 	{
-		RunRootRetarget(InSourceGlobalPose, TargetSkeleton.OutputGlobalPose);
-		// update global transforms below root
-		TargetSkeleton.UpdateGlobalTransformsBelowBone(RootRetargeter.Target.BoneIndex, TargetSkeleton.RetargetLocalPose, TargetSkeleton.OutputGlobalPose);
+		RunRootRetarget(Context, SourceGlobalPose, OutputGlobalPose);
+		UpdateBelowRoot(Context, OutputGlobalPose, bFullUpdate);
+		ValidatePose(Context, OutputGlobalPose, TargetSkeleton, "root");
 	}
 	
 	// FK CHAIN retargeting
-	if (GlobalSettings.bEnableFK && bAtLeastOneValidBoneChainPair)
+	if (bRunFK)
 	{
-		RunFKRetarget(InSourceGlobalPose, TargetSkeleton.OutputGlobalPose);
-		// update all the bones that are not controlled by FK chains or root
-		TargetSkeleton.UpdateGlobalTransformsAllNonRetargetedBones(TargetSkeleton.OutputGlobalPose);
+		RunFKRetarget(Context, SourceGlobalPose, OutputGlobalPose);
+		UpdateNonRetargetedBones(OutputGlobalPose, bFullUpdate);
+		ValidatePose(Context, OutputGlobalPose, TargetSkeleton, "fk");
 	}
 	
 	// IK CHAIN retargeting
 	if (GlobalSettings.bEnableIK && bAtLeastOneValidBoneChainPair && bIKRigInitialized)
 	{
-		RunIKRetarget(InSourceGlobalPose, TargetSkeleton.OutputGlobalPose, SpeedValuesFromCurves, DeltaTime);
+		RunIKRetarget(Context, SourceGlobalPose, OutputGlobalPose, SpeedValuesFromCurves, DeltaTime);
+		ValidatePose(Context, OutputGlobalPose, TargetSkeleton, "ik");
 	}
 
 	// Pole Vector matching between source / target chains
 	if (GlobalSettings.bEnableFK && bAtLeastOneValidBoneChainPair)
 	{
-		RunPoleVectorMatching(InSourceGlobalPose, TargetSkeleton.OutputGlobalPose);
+		RunPoleVectorMatching(Context, SourceGlobalPose, OutputGlobalPose);
+		ValidatePose(Context, OutputGlobalPose, TargetSkeleton, "pole vector");
 	}
 
-	return TargetSkeleton.OutputGlobalPose;
+	if (bFileOrder)
+	{
+		return;
+	}
+	if (bFullUpdate || bNewOutputPose)
+	{
+		TargetSkeleton.Hierarchy.ToFile(OutputGlobalPose, OutTargetGlobalPose);
+	}
+	else
+	{
+		TargetSkeleton.CopyDirtyBonesToFileOrder(OutputGlobalPose, OutTargetGlobalPose);
+	}
+}
+
+void FRetargetPlan::RunRetargeterBatch(
+	FRetargetContext& Context,
+	const FTransform* InSourceGlobalPoses,
+	const int32 NumFrames,
+	FTransform* OutTargetGlobalPoses,
+	const std::unordered_map<FName, float>& SpeedValuesFromCurves,
+	const float DeltaTime) const
+{
+	if (NumFrames <= 0)
+	{
+		return;
+	}
+
+	const int32 NumSourceBones = SourceSkeleton.Hierarchy.Num();
+	const int32 NumTargetBones = TargetSkeleton.Hierarchy.Num();
+	if (Context.BatchFrames.size() < NumFrames)
+	{
+		Context.BatchFrames.resize(NumFrames);
+	}
+	TArray<FRetargetContext::FBatchFrame>& Frames = Context.BatchFrames;
+
+	// frames of the batch are numbered as if they were run one by one
+	const int32 FirstFrame = Context.PoseValidator.GetFrame() + 1;
+
+	for (int32 Frame=0; Frame<NumFrames; ++Frame)
+	{
+		FRetargetContext::FBatchFrame& BatchFrame = Frames[Frame];
+		const FTransform* InSourceGlobalPose = InSourceGlobalPoses + (size_t)Frame * NumSourceBones;
+		BatchFrame.SourceGlobalPose.resize(NumSourceBones);
+		if (SourceSkeleton.Hierarchy.IsFileOrder())
+		{
+			std::copy(InSourceGlobalPose, InSourceGlobalPose + NumSourceBones, BatchFrame.SourceGlobalPose.begin());
+		}
+		else
+		{
+			SourceSkeleton.Hierarchy.ToSorted(InSourceGlobalPose, BatchFrame.SourceGlobalPose.data());
+		}
+		Context.PoseValidator.SetFrame(FirstFrame + Frame);
+		ValidatePose(Context, BatchFrame.SourceGlobalPose, SourceSkeleton, "source");
+		ResetOutputPose(BatchFrame.OutputGlobalPose, BatchFrame.bNeedsFullUpdate);
+	}
+
+	if (bRunRoot)
+	{
+		for (int32 Frame=0; Frame<NumFrames; ++Frame)
+		{
+			FRetargetContext::FBatchFrame& BatchFrame = Frames[Frame];
+			RunRootRetarget(Context, BatchFrame.SourceGlobalPose, BatchFrame.OutputGlobalPose);
+			UpdateBelowRoot(Context, BatchFrame.OutputGlobalPose, BatchFrame.bNeedsFullUpdate);
+			Context.PoseValidator.SetFrame(FirstFrame + Frame);
+			ValidatePose(Context, BatchFrame.OutputGlobalPose, TargetSkeleton, "root");
+		}
+	}
+
+	if (bRunFK)
+	{
+		const auto RunFKChainOverFrames = [&](int32 ChainIndex)
+		{
+			for (int32 Frame=0; Frame<NumFrames; ++Frame)
+			{
+				RunFKChain(Context, ChainIndex, Frames[Frame].SourceGlobalPose, Frames[Frame].OutputGlobalPose);
+			}
+		};
+		if (ChainGraphFK.Num() > 0)
+		{
+			ParallelForGraph(ChainGraphFK, RunFKChainOverFrames);
+		}
+		else
+		{
+			for (int32 ChainIndex=0; ChainIndex<ChainPairsFK.size(); ++ChainIndex)
+			{
+				RunFKChainOverFrames(ChainIndex);
+			}
+		}
+
+		for (int32 Frame=0; Frame<NumFrames; ++Frame)
+		{
+			FRetargetContext::FBatchFrame& BatchFrame = Frames[Frame];
+			UpdateNonRetargetedBones(BatchFrame.OutputGlobalPose, BatchFrame.bNeedsFullUpdate);
+			Context.PoseValidator.SetFrame(FirstFrame + Frame);
+			ValidatePose(Context, BatchFrame.OutputGlobalPose, TargetSkeleton, "fk");
+		}
+	}
+
+	for (int32 Frame=0; Frame<NumFrames; ++Frame)
+	{
+		FRetargetContext::FBatchFrame& BatchFrame = Frames[Frame];
+		Context.PoseValidator.SetFrame(FirstFrame + Frame);
+
+		if (GlobalSettings.bEnableIK && bAtLeastOneValidBoneChainPair && bIKRigInitialized)
+		{
+			RunIKRetarget(Context, BatchFrame.SourceGlobalPose, BatchFrame.OutputGlobalPose, SpeedValuesFromCurves, DeltaTime);
+			ValidatePose(Context, BatchFrame.OutputGlobalPose, TargetSkeleton, "ik");
+		}
+
+		if (GlobalSettings.bEnableFK && bAtLeastOneValidBoneChainPair)
+		{
+			RunPoleVectorMatching(Context, BatchFrame.SourceGlobalPose, BatchFrame.OutputGlobalPose);
+			ValidatePose(Context, BatchFrame.OutputGlobalPose, TargetSkeleton, "pole vector");
+		}
+
+		FTransform* OutTargetGlobalPose = OutTargetGlobalPoses + (size_t)Frame * NumTargetBones;
+		if (TargetSkeleton.Hierarchy.IsFileOrder())
+		{
+			std::copy(BatchFrame.OutputGlobalPose.begin(), BatchFrame.OutputGlobalPose.end(), OutTargetGlobalPose);
+		}
+		else
+		{
+			TargetSkeleton.Hierarchy.ToFile(BatchFrame.OutputGlobalPose.data(), OutTargetGlobalPose);
+		}
+		BatchFrame.bNeedsFullUpdate = false;
+	}
+}
+
+void FRetargetPlan::ResetOutputPose(TArray<FTransform>& OutputGlobalPose, const bool bFullUpdate) const
+{
+	// the first frame of a context starts from the full retarget pose and updates every bone,
+	// later frames only reset and update the bones the stages can move
+	if (bFullUpdate)
+	{
+		OutputGlobalPose = TargetSkeleton.RetargetGlobalPose;
+	}
+	else
+	{
+		TargetSkeleton.ResetDirtyRetargetedBones(OutputGlobalPose);
+	}
+}
+
+void FRetargetPlan::UpdateBelowRoot(FRetargetContext& Context, TArray<FTransform>& OutputGlobalPose, const bool bFullUpdate) const
+{
+	// update global transforms below root
+	// the FK stage rebuilds every parent it reads and then every non retargeted bone, so this is only needed without it
+	if (!bFullUpdate && bRunFK)
+	{
+		return;
+	}
+
+	if (bDualQuatPoses)
+	{
+		TargetSkeleton.UpdateGlobalTransformsBelowBone(RootRetargeter.Target.BoneIndex, TargetSkeleton.RetargetLocalDualQuats, Context.TargetGlobalDualQuats, OutputGlobalPose);
+	}
+	else
+	{
+		TargetSkeleton.UpdateGlobalTransformsBelowBone(RootRetargeter.Target.BoneIndex, TargetSkeleton.RetargetLocalPose, OutputGlobalPose);
+	}
+}
+
+void FRetargetPlan::UpdateNonRetargetedBones(TArray<FTransform>& OutputGlobalPose, const bool bFullUpdate) const
+{
+	// update all the bones that are not controlled by FK chains or root
+	if (bFullUpdate)
+	{
+		TargetSkeleton.UpdateGlobalTransformsAllNonRetargetedBones(OutputGlobalPose);
+	}
+	else
+	{
+		TargetSkeleton.UpdateGlobalTransformsDirtyNonRetargetedBones(OutputGlobalPose);
+	}
+}
+
+void FRetargetPlan::ValidatePose(FRetargetContext& Context, const TArray<FTransform>& Pose, const FRetargetSkeleton& Skeleton, const char* Stage) const
+{
+#if IKRIG_VALIDATE_POSES
+	FPoseValidator& PoseValidator = Context.PoseValidator;
+	const bool bHadError = PoseValidator.HasError();
+	if (!PoseValidator.Validate(Pose, Stage) && !bHadError)
+	{
+		const FPoseValidationError& Error = PoseValidator.FirstError;
+		Context.Log.LogError("invalid pose after %s: %s at bone %d (%s), frame %d",
+			Error.Stage,
+			PoseErrorToString(Error.Error),
+			Error.BoneIndex,
+			Skeleton.BoneNames[Error.BoneIndex].c_str(),
+			Error.Frame);
+	}
+#endif
 }
 
-void UIKRetargetProcessor::RunRootRetarget(
+void FRetargetPlan::RunRetargeter(
+	FRetargetContext& Context,
+	const FPoseSoA& InSourceGlobalPose,
+	FPoseSoA& OutTargetGlobalPose,
+	const std::unordered_map<FName, float>& SpeedValuesFromCurves,
+	const float DeltaTime) const
+{
+	// chain retargeters index whole transforms, so convert at the boundary
+	InSourceGlobalPose.CopyTo(Context.SourceGlobalPoseAoS);
+	const TArray<FTransform>& TargetGlobalPose = RunRetargeter(Context, Context.SourceGlobalPoseAoS, SpeedValuesFromCurves, DeltaTime);
+	OutTargetGlobalPose.CopyFrom(TargetGlobalPose);
+}
+
+void FRetargetPlan::RunRetargeter(
+	FRetargetContext& Context,
+	const FRetargetBoneMask& Mask,
+	const TArray<FTransform>& InSourceGlobalPose,
+	TArray<FTransform>& OutMaskedGlobalPose,
+	const std::unordered_map<FName, float>& SpeedValuesFromCurves,
+	const float DeltaTime) const
+{
+	if (Mask.Plan != this)
+	{
+		Context.Log.LogError("BoneMaskFromOtherPlan, build the mask with InitializeBoneMask of this plan");
+		return;
+	}
+
+	// only the source bones the masked stages read are brought to hierarchy order
+	const TArray<FTransform>* SourceGlobalPosePtr = &InSourceGlobalPose;
+	if (!SourceSkeleton.Hierarchy.IsFileOrder())
+	{
+		const TArray<int32>& SortedToFile = SourceSkeleton.Hierarchy.SortedToFile;
+		Context.SourceGlobalPoseSorted.resize(SortedToFile.size());
+		for (const int32 BoneIndex : Mask.SourceBoneIndices)
+		{
+			Context.SourceGlobalPoseSorted[BoneIndex] = InSourceGlobalPose[SortedToFile[BoneIndex]];
+		}
+		SourceGlobalPosePtr = &Context.SourceGlobalPoseSorted;
+	}
+	const TArray<FTransform>& SourceGlobalPose = *SourceGlobalPosePtr;
+	TArray<FTransform>& OutputGlobalPose = Context.OutputGlobalPose;
+
+	Context.PoseValidator.NextFrame();
+
+	// bones outside the dirty lists hold their retarget pose from the first run of the context, masked or not,
+	// and every dirty masked bone is rewritten below, so switching masks needs no full update
+	if (Context.bNeedsFullUpdate)
+	{
+		OutputGlobalPose = TargetSkeleton.RetargetGlobalPose;
+		Context.bNeedsFullUpdate = false;
+	}
+	for (const int32 BoneIndex : Mask.DirtyRetargetedBoneIndices)
+	{
+		OutputGlobalPose[BoneIndex] = TargetSkeleton.RetargetGlobalPose[BoneIndex];
+	}
+
+	if (Mask.bRunRoot)
+	{
+		RunRootRetarget(Context, SourceGlobalPose, OutputGlobalPose);
+	}
+
+	for (const int32 ChainIndex : Mask.ChainPairsFK)
+	{
+		RunFKChain(Context, ChainIndex, SourceGlobalPose, OutputGlobalPose);
+	}
+
+	for (const int32 BoneIndex : Mask.DirtyNonRetargetedBoneIndices)
+	{
+		TargetSkeleton.UpdateGlobalTransformOfSingleBone(BoneIndex, TargetSkeleton.RetargetLocalPose, OutputGlobalPose);
+	}
+	ValidatePose(Context, OutputGlobalPose, TargetSkeleton, "masked");
+
+	OutMaskedGlobalPose.resize(Mask.HierarchyBoneIndices.size());
+	for (int32 MaskIndex=0; MaskIndex<Mask.HierarchyBoneIndices.size(); ++MaskIndex)
+	{
+		OutMaskedGlobalPose[MaskIndex] = OutputGlobalPose[Mask.HierarchyBoneIndices[MaskIndex]];
+	}
+}
+
+void FRetargetPlan::RunRootRetarget(
+	FRetargetContext& Context,
 	const TArray<FTransform>& InGlobalTransforms,
-    TArray<FTransform>& OutGlobalTransforms)
+    TArray<FTransform>& OutGlobalTransforms) const
 {
-	RootRetargeter.EncodePose(InGlobalTransforms);
-	RootRetargeter.DecodePose(OutGlobalTransforms);
+	RootRetargeter.EncodePose(InGlobalTransforms, Context.Root);
+	RootRetargeter.DecodePose(Context.Root, OutGlobalTransforms);
 }
 
-void UIKRetargetProcessor::RunFKRetarget(
+void FRetargetPlan::RunFKRetarget(
+	FRetargetContext& Context,
 	const TArray<FTransform>& InGlobalTransforms,
-    TArray<FTransform>& OutGlobalTransforms)
+    TArray<FTransform>& OutGlobalTransforms) const
 {
+	if (ChainGraphFK.Num() > 0)
+	{
+		ParallelForGraph(ChainGraphFK, [&](int32 ChainIndex)
+		{
+			RunFKChain(Context, ChainIndex, InGlobalTransforms, OutGlobalTransforms);
+		});
+		return;
+	}
+
 	// spin through chains and encode/decode them all using the input pose
-	for (FRetargetChainPairFK& ChainPair : ChainPairsFK)
+	for (int32 ChainIndex=0; ChainIndex<ChainPairsFK.size(); ++ChainIndex)
 	{
-		ChainPair.FKEncoder.EncodePose(
-			SourceSkeleton,
-			ChainPair.SourceBoneIndices,
-			InGlobalTransforms);
-		
-		ChainPair.FKDecoder.DecodePose(
-			RootRetargeter,
-			ChainPair.Settings,
-			ChainPair.TargetBoneIndices,
-			ChainPair.FKEncoder,
-			TargetSkeleton,
-			OutGlobalTransforms);
+		RunFKChain(Context, ChainIndex, InGlobalTransforms, OutGlobalTransforms);
 	}
 }
 
-void UIKRetargetProcessor::RunIKRetarget(
+void FRetargetPlan::RunFKChain(
+	FRetargetContext& Context,
+	const int32 ChainIndex,
+	const TArray<FTransform>& InGlobalTransforms,
+    TArray<FTransform>& OutGlobalTransforms) const
+{
+	const FRetargetChainPairFK& ChainPair = ChainPairsFK[ChainIndex];
+	FChainFKState& SourceState = Context.SourceChainsFK[ChainIndex];
+
+	ChainPair.FKEncoder.EncodePose(
+		SourceSkeleton,
+		ChainPair.SourceBoneIndices,
+		InGlobalTransforms,
+		SourceState);
+	
+	ChainPair.FKDecoder.DecodePose(
+		RootRetargeter,
+		ChainPair.Settings,
+		ChainPair.TargetBoneIndices,
+		ChainPair.FKEncoder,
+		SourceState,
+		Context.TargetChainsFK[ChainIndex],
+		TargetSkeleton,
+		OutGlobalTransforms);
+}
+
+void FRetargetPlan::RunIKRetarget(
+	FRetargetContext& Context,
 	const TArray<FTransform>& InSourceGlobalPose,
     TArray<FTransform>& OutTargetGlobalPose,
     const std::unordered_map<FName, float>& SpeedValuesFromCurves,
-    const float DeltaTime)
+    const float DeltaTime) const
 {
 	// todo
 }
 
-void UIKRetargetProcessor::RunPoleVectorMatching(const TArray<FTransform>& InGlobalTransforms, TArray<FTransform>& OutGlobalTransforms) {
+void FRetargetPlan::RunPoleVectorMatching(FRetargetContext& Context, const TArray<FTransform>& InGlobalTransforms, TArray<FTransform>& OutGlobalTransforms) const {
 	// todo
 }
 
-void UIKRetargetProcessor::RunStrideWarping(const TArray<FTransform>& InTargetGlobalPose)
+void FRetargetPlan::RunStrideWarping(FRetargetContext& Context, const TArray<FTransform>& InTargetGlobalPose) const
 {
 	// todo
 }
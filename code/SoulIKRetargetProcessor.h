@@ -9,6 +9,11 @@
 
 #include <stdarg.h>
 #include "SoulRetargeter.h"
+#include "SoulPoseSoA.h"
+#include "SoulPoseValidation.h"
+#include "SoulDualQuat.h"
+#include "SoulBoneHierarchy.h"
+#include "SoulParallel.h"
 
 
 namespace SoulIK {
@@ -61,15 +66,24 @@ private:
 	std::unordered_map<FName, FQuat> BoneRotationOffsets;
 };
 
+// all per-bone arrays are in Hierarchy (parent before child) order, which may differ from the USkeleton order,
+// poses are remapped at the UIKRetargetProcessor::RunRetargeter boundary
 struct FRetargetSkeleton
 {
-	std::vector<FName> BoneNames;				// list of all bone names in ref skeleton order
-	std::vector<int32_t> ParentIndices;			// per-bone indices of parent bones (the hierarchy)
+	FBoneHierarchy Hierarchy;					// sorted order and remap to USkeleton order
+	EHierarchyError HierarchyError = EHierarchyError::None;
+	std::vector<FName> BoneNames;				// list of all bone names in hierarchy order
+	TMap<FName, int32> BoneIndexByName;			// BoneNames -> index
+	std::vector<int32_t> ParentIndices;			// per-bone indices of parent bones, ParentIndices[i] < i
 	std::vector<FTransform> RetargetLocalPose;	// local space retarget pose
 	std::vector<FTransform> RetargetGlobalPose;	// global space retarget pose
 	FName RetargetPoseName;						// the name of the retarget pose this was initialized with
 	USkeleton* Skeleton;							// the skeletal mesh this was initialized with
 	std::vector<FName> ChainThatContainsBone;	// record which chain is actually controlling each bone
+	std::vector<FDualQuat> RetargetLocalDualQuats;	// RetargetLocalPose as dual quaternions, filled by InitializeDualQuats()
+	FBoneLevels Levels;							// ParentIndices grouped by depth
+	bool bUpdateByLevel = false;				// FTransform hierarchy updates go through Levels
+	int32_t ParallelLevelMinBones = INDEX_NONE;	// see FBoneLevels::LocalToGlobal
 
 	void Initialize(
 		USkeleton* InSkeleton,
@@ -87,6 +101,11 @@ struct FRetargetSkeleton
 
 	int32_t FindBoneIndexByName(const FName InName) const;
 
+	// true if every bone of the retarget pose has unit scale, ie. the pose fits in dual quaternions
+	bool HasUnitScale() const;
+
+	void InitializeDualQuats();
+
 	int32_t GetParentIndex(const int32_t BoneIndex) const;
 
 	void UpdateGlobalTransformsBelowBone(
@@ -94,6 +113,19 @@ struct FRetargetSkeleton
 		const std::vector<FTransform>& InLocalPose,
 		std::vector<FTransform>& OutGlobalPose) const;
 
+	void UpdateGlobalTransformsBelowBone(
+		const int32_t StartBoneIndex,
+		const FPoseSoA& InLocalPose,
+		FPoseSoA& OutGlobalPose) const;
+
+	// dual quaternion hierarchy update, scale of OutGlobalPose is reset to one below StartBoneIndex
+	// ScratchGlobalPose holds the global dual quaternions while walking down the hierarchy
+	void UpdateGlobalTransformsBelowBone(
+		const int32_t StartBoneIndex,
+		const std::vector<FDualQuat>& InLocalPose,
+		std::vector<FDualQuat>& ScratchGlobalPose,
+		std::vector<FTransform>& OutGlobalPose) const;
+
 	void UpdateLocalTransformsBelowBone(
 		const int32_t StartBoneIndex,
 		std::vector<FTransform>& OutLocalPose,
@@ -113,28 +145,27 @@ struct FRetargetSkeleton
 		const int32_t BoneIndex,
 		const std::vector<FTransform>& InGlobalPose) const;
 
-	int32_t GetCachedEndOfBranchIndex(const int32_t InBoneIndex) const;
+	// last bone of the branch below InBoneIndex, INDEX_NONE for a leaf, the branch is the range (InBoneIndex, End]
+	int32_t GetEndOfBranchIndex(const int32_t InBoneIndex) const;
 
 	void GetChildrenIndices(const int32_t BoneIndex, std::vector<int32_t>& OutChildren) const;
 
 	void GetChildrenIndicesRecursive(const int32_t BoneIndex, std::vector<int32_t>& OutChildren) const;
 	
 	bool IsParentOfChild(const int32_t PotentialParentIndex, const int32_t ChildBoneIndex) const;
-
-private:
-	
-	/** One index per-bone. Lazy-filled on request. Stores the last element of the branch below the bone.
-	 * You can iterate between in the indices stored here and the bone in question to iterate over all children recursively */
-	mutable std::vector<int32_t> CachedEndOfBranchIndices;
 };
 
 struct FTargetSkeleton : public FRetargetSkeleton
 {
-	std::vector<FTransform> OutputGlobalPose;
 	// true for bones that are in a target chain that is ALSO mapped to a source chain
 	// ie, bones that are actually posed based on a mapped source chain
 	std::vector<bool> IsBoneRetargeted;
 
+	// static dirty analysis for the stages the plan runs (see InitializeDirtyBones)
+	// bones outside both lists only depend on the retarget pose, they keep the value of the first full update
+	std::vector<int32_t> DirtyRetargetedBoneIndices;		// written by the root / FK stages every frame
+	std::vector<int32_t> DirtyNonRetargetedBoneIndices;	// below a written bone and not written themselves, parent before child
+
 	void Initialize(
 		USkeleton* InSkeletalMesh,
 		const std::vector<FBoneChain>& BoneChains,
@@ -146,7 +177,19 @@ struct FTargetSkeleton : public FRetargetSkeleton
 
 	void SetBoneIsRetargeted(const int32_t BoneIndex, const bool IsRetargeted);
 
-	void UpdateGlobalTransformsAllNonRetargetedBones(std::vector<FTransform>& InOutGlobalPose);
+	void UpdateGlobalTransformsAllNonRetargetedBones(std::vector<FTransform>& InOutGlobalPose) const;
+
+	// @param bRootDriven - the root stage writes RootBoneIndex every frame
+	// @param bChainsDriven - the FK stage writes every retargeted chain bone every frame
+	void InitializeDirtyBones(const bool bRootDriven, const bool bChainsDriven, const int32_t RootBoneIndex);
+
+	// put the written bones back in the retarget pose, the stages only overwrite part of them (ie. root scale)
+	void ResetDirtyRetargetedBones(std::vector<FTransform>& InOutGlobalPose) const;
+
+	void UpdateGlobalTransformsDirtyNonRetargetedBones(std::vector<FTransform>& InOutGlobalPose) const;
+
+	// copy the bones of both dirty lists from a hierarchy order pose to a USkeleton order pose
+	void CopyDirtyBonesToFileOrder(const std::vector<FTransform>& InGlobalPose, std::vector<FTransform>& InOutFileGlobalPose) const;
 };
 
 
@@ -180,9 +223,6 @@ struct FRootSource
 	FQuat InitialRotation;
 	float InitialHeightInverse;
 	FVector InitialPosition;
-	FVector CurrentPosition;
-	FVector CurrentPositionNormalized;
-	FQuat CurrentRotation;
 };
 
 struct FRootTarget
@@ -194,7 +234,17 @@ struct FRootTarget
 	FVector InitialPosition;
 	FQuat InitialRotation;
 	float InitialHeight;
+};
 
+// per-call values of the root retargeter, see FRetargetContext
+struct FRootRetargeterState
+{
+	// encoded source root
+	FVector CurrentPosition;
+	FVector CurrentPositionNormalized;
+	FQuat CurrentRotation;
+
+	// delta created by all the modifications made to the decoded target root
 	FVector RootTranslationDelta;
 	FQuat RootRotationDelta;
 };
@@ -221,9 +271,9 @@ struct FRootRetargeter
 		const FTargetSkeleton& TargetSkeleton,
 		FIKRigLogger& Log);
 
-	void EncodePose(const TArray<FTransform> &SourceGlobalPose);
+	void EncodePose(const TArray<FTransform> &SourceGlobalPose, FRootRetargeterState& State) const;
 	
-	void DecodePose(TArray<FTransform> &OutTargetGlobalPose);
+	void DecodePose(FRootRetargeterState& State, TArray<FTransform> &OutTargetGlobalPose) const;
 
 	FVector GetGlobalScaleVector() const
 	{
@@ -237,26 +287,59 @@ private:
 
 ////////////////////////////////////////////////////////////////////////
 //   chain retargeter
+
+// per-call transforms of one FK chain, see FRetargetContext
+struct FChainFKState
+{
+	TArray<FTransform> CurrentGlobalTransforms;
+	TArray<FDualQuat> CurrentGlobalDualQuats;
+
+	// encoder: local transforms of a chain re-parented under a non uniform scale, decoder: scratch of the alpha blend
+	TArray<FTransform> CurrentLocalTransforms;
+
+	// encoder only
+	FTransform ChainParentCurrentGlobalTransform;
+
+	// encoder: this frame's chain is in CurrentGlobalDualQuats, false when the mode is off or the source pose has scale
+	bool bDualQuatPose = false;
+};
+
+// where a target bone param falls on the source chain, see FChainDecoderFK::InitializeSourceBrackets
+struct FChainParamBracket
+{
+	int32_t PrevIndex = 0;				// INDEX_NONE: param past the end of the chain, identity
+	int32_t NextIndex = INDEX_NONE;		// INDEX_NONE: take PrevIndex as is
+	float Alpha = 0.0f;					// blend from PrevIndex to NextIndex
+};
+
 struct FChainFK
 {
 	TArray<FTransform> InitialGlobalTransforms;
 
 	TArray<FTransform> InitialLocalTransforms;
 
-	TArray<FTransform> CurrentGlobalTransforms;
-
 	TArray<float> Params;
 	TArray<int32_t> BoneIndices;
 
 	int32_t ChainParentBoneIndex;
 	FTransform ChainParentInitialGlobalTransform;
 
+	// dual quaternion mode (FRetargetGlobalSettings::bDualQuatPoses)
+	bool bUseDualQuat = false;
+	TArray<FDualQuat> InitialGlobalDualQuats;
+
 	bool Initialize(
 		const FRetargetSkeleton& Skeleton,
 		const TArray<int32_t>& InBoneIndices,
 		const TArray<FTransform> &InitialGlobalPose,
 		FIKRigLogger& Log);
 
+	// switch to dual quaternion mode, call after Initialize()
+	void EnableDualQuat();
+
+	// size State for this chain and put it in the retarget pose
+	void InitializeState(FChainFKState& State) const;
+
 private:
 	
 	bool CalculateBoneParameters(FIKRigLogger& Log);
@@ -272,21 +355,20 @@ protected:
 	void PutCurrentTransformsInRefPose(
 		const TArray<int32_t>& BoneIndices,
 		const FRetargetSkeleton& Skeleton,
-		const TArray<FTransform>& InCurrentGlobalPose);
+		const TArray<FTransform>& InCurrentGlobalPose,
+		FChainFKState& State) const;
 };
 
 struct FChainEncoderFK : public FChainFK
 {
-	TArray<FTransform> CurrentLocalTransforms;
-
-	FTransform ChainParentCurrentGlobalTransform;
-	
 	void EncodePose(
 		const FRetargetSkeleton& SourceSkeleton,
 		const TArray<int32>& SourceBoneIndices,
-		const TArray<FTransform> &InSourceGlobalPose);
+		const TArray<FTransform> &InSourceGlobalPose,
+		FChainFKState& State) const;
 
-	void TransformCurrentChainTransforms(const FTransform& NewParentTransform);
+	// moves the encoded chain under NewParentTransform in place of its source chain parent, keeping its local transforms
+	void TransformCurrentChainTransforms(const FTransform& NewParentTransform, FChainFKState& State) const;
 };
 
 struct FChainDecoderFK : public FChainFK
@@ -295,34 +377,56 @@ struct FChainDecoderFK : public FChainFK
 		const int32_t RetargetRootBoneIndex,
 		const int32_t ChainRootBoneIndex,
 		const FTargetSkeleton& TargetSkeleton);
+
+	// find the source bones around each target param and the chain parent offset once, both chains are fixed after Initialize()
+	// call again after EnableDualQuat(), the interpolated initial source transforms depend on it
+	void InitializeSourceBrackets(const FChainEncoderFK& SourceChain);
 	
+	// @param SourceState - encoded by SourceChain this frame, moved under the target chain parent here
+	// @param State - receives the decoded chain
 	void DecodePose(
 		const FRootRetargeter& RootRetargeter,
 		const FTargetChainSettings& Settings,
 		const TArray<int32_t>& TargetBoneIndices,
-		FChainEncoderFK& SourceChain,
+		const FChainEncoderFK& SourceChain,
+		FChainFKState& SourceState,
+		FChainFKState& State,
 		const FTargetSkeleton& TargetSkeleton,
-		TArray<FTransform> &InOutGlobalPose);
+		TArray<FTransform> &InOutGlobalPose) const;
+
+	// non retargeted bones between this chain and the next retargeted parent, root first, DecodePose() writes them too
+	const TArray<int32>& GetIntermediateParentIndices() const { return IntermediateParentIndices; }
 
 	void MatchPoleVector(
 		const FTargetChainSettings& Settings,
 		const TArray<int32_t>& TargetBoneIndices,
-		FChainEncoderFK& SourceChain,
+		const FChainEncoderFK& SourceChain,
+		const FChainFKState& SourceState,
 		const FTargetSkeleton& TargetSkeleton,
-		TArray<FTransform> &InOutGlobalPose);
+		TArray<FTransform> &InOutGlobalPose) const;
 
 private:
 	
-	FTransform GetTransformAtParam(
+	static FTransform GetTransformAtBracket(
 		const TArray<FTransform>& Transforms,
-		const TArray<float>& InParams,
-		const float& Param) const;
+		const FChainParamBracket& Bracket);
+
+	static FTransform GetDualQuatAtBracket(
+		const TArray<FDualQuat>& DualQuats,
+		const FChainParamBracket& Bracket);
 	
 	void UpdateIntermediateParents(
 		const FTargetSkeleton& TargetSkeleton,
-		TArray<FTransform> &InOutGlobalPose);
+		TArray<FTransform> &InOutGlobalPose) const;
 
 	TArray<int32> IntermediateParentIndices;
+
+	// Interpolated rotation mode, per target chain bone
+	TArray<FChainParamBracket> SourceBrackets;
+	TArray<FTransform> SourceInitialTransformsAtParam;
+
+	// source chain parent relative to the target chain parent in retarget pose
+	FTransform SourceChainParentInitialDelta;
 };
 
 struct FDecodedIKChain
@@ -451,6 +555,200 @@ struct FRetargetChainPairIK : FRetargetChainPair
 };
 
 
+struct FRetargetPlan;
+
+// subset of the target skeleton a masked RunRetargeter keeps up to date, ie. root and a few chains for a background character
+// built once by FRetargetPlan::InitializeBoneMask() and only valid for that plan, a run costs about as much as the bones it covers
+struct FRetargetBoneMask
+{
+	// masked bones in USkeleton order, OutMaskedGlobalPose[i] is the pose of BoneIndices[i]
+	TArray<int32_t> BoneIndices;
+
+	// hierarchy order
+	TArray<int32_t> HierarchyBoneIndices;			// per BoneIndices
+	TArray<int32_t> ChainPairsFK;					// FRetargetPlan::ChainPairsFK that write a masked bone
+	TArray<int32_t> SourceBoneIndices;				// source bones read by the root and those chains
+	TArray<int32_t> DirtyRetargetedBoneIndices;		// FTargetSkeleton lists restricted to the mask
+	TArray<int32_t> DirtyNonRetargetedBoneIndices;	// also holds the unwritten chain bones when FK is off
+	bool bRunRoot = false;
+
+	const FRetargetPlan* Plan = nullptr;
+};
+
+// everything a retarget run writes, one per thread / concurrent request, the FRetargetPlan it runs against is never modified
+// sized by Initialize(), after that a run allocates nothing unless the caller's pose sizes change
+struct FRetargetContext
+{
+	// size every buffer for InPlan and start over from its retarget pose, again when switching to another plan
+	// the context keeps InPlan alive until it is initialized for another one
+	void Initialize(std::shared_ptr<const FRetargetPlan> InPlan);
+
+	std::shared_ptr<const FRetargetPlan> Plan;	// the plan this context was initialized for
+
+	FRootRetargeterState Root;
+	TArray<FChainFKState> SourceChainsFK;		// per FRetargetPlan::ChainPairsFK, encoded source chains
+	TArray<FChainFKState> TargetChainsFK;		// per FRetargetPlan::ChainPairsFK, decoded target chains
+
+	// result of the last run in hierarchy order, bones the plan never moves keep their retarget pose
+	TArray<FTransform> OutputGlobalPose;
+	bool bNeedsFullUpdate = true;				// the next run updates every bone, not only the dirty ones
+
+	// pose checks between retarget stages, compiled out unless IKRIG_VALIDATE_POSES
+	FPoseValidator PoseValidator;
+	FIKRigLogger Log;
+
+	// source pose of the SoA RunRetargeter, converted once per call
+	TArray<FTransform> SourceGlobalPoseAoS;
+
+	// poses remapped between USkeleton order and hierarchy order, only used when the two differ
+	TArray<FTransform> SourceGlobalPoseSorted;
+	TArray<FTransform> TargetGlobalPoseFileOrder;
+
+	// target global pose as dual quaternions during the root hierarchy update
+	TArray<FDualQuat> TargetGlobalDualQuats;
+
+	// per frame poses of RunRetargeterBatch, grown to the largest batch, each output is updated like OutputGlobalPose
+	struct FBatchFrame
+	{
+		TArray<FTransform> SourceGlobalPose;	// hierarchy order
+		TArray<FTransform> OutputGlobalPose;
+		bool bNeedsFullUpdate = true;
+	};
+	TArray<FBatchFrame> BatchFrames;
+};
+
+// compiled retarget definition: skeletons, chain pairs, root and settings
+// nothing changes after Initialize(), so one plan can be shared by any number of threads each running its own FRetargetContext
+struct FRetargetPlan
+{
+	// @return true if the plan can run, see UIKRetargetProcessor::Initialize
+	bool Initialize(
+		USkeleton *InSourceSkeleton,
+		USkeleton *InTargetSkeleton,
+		UIKRetargeter* InRetargeterAsset,
+		FIKRigLogger& Log);
+
+	// Run the retarget to generate a new pose.
+	// @param Context - per-call state, initialized for this plan, only one thread may use it at a time
+	// @param InSourceGlobalPose -  is the source mesh input pose in Component/Global space
+	// @return The retargeted Component/Global space pose for the target skeleton, owned by Context
+	TArray<FTransform>& RunRetargeter(
+		FRetargetContext& Context,
+		const TArray<FTransform>& InSourceGlobalPose,
+		const std::unordered_map<FName, float>& SpeedValuesFromCurves,
+		const float DeltaTime) const;
+
+	// Same as above, written to a pose the caller keeps, in USkeleton order like the source pose.
+	// @param bReuseOutputPose - OutTargetGlobalPose holds the result of an earlier run on Context and was not modified since,
+	//		only the bones the plan can move are written, so memory traffic follows the moving bones.
+	//		Otherwise, or after Context.Initialize(), all of it is written.
+	void RunRetargeter(
+		FRetargetContext& Context,
+		const TArray<FTransform>& InSourceGlobalPose,
+		TArray<FTransform>& OutTargetGlobalPose,
+		const std::unordered_map<FName, float>& SpeedValuesFromCurves,
+		const float DeltaTime,
+		const bool bReuseOutputPose = false) const;
+
+	// Same as above with SoA poses (SoulPoseSoA.h).
+	void RunRetargeter(
+		FRetargetContext& Context,
+		const FPoseSoA& InSourceGlobalPose,
+		FPoseSoA& OutTargetGlobalPose,
+		const std::unordered_map<FName, float>& SpeedValuesFromCurves,
+		const float DeltaTime) const;
+
+	// Same as above for NumFrames poses at once, ie. a clip, the result of each frame is the same as a RunRetargeter call.
+	// Each stage runs over all frames before the next one, and each FK chain over all frames before the next chain.
+	// @param InSourceGlobalPoses - NumFrames source poses of SourceSkeleton bones in USkeleton order, back to back
+	// @param OutTargetGlobalPoses - receives NumFrames target poses of TargetSkeleton bones in USkeleton order
+	void RunRetargeterBatch(
+		FRetargetContext& Context,
+		const FTransform* InSourceGlobalPoses,
+		const int32_t NumFrames,
+		FTransform* OutTargetGlobalPoses,
+		const std::unordered_map<FName, float>& SpeedValuesFromCurves,
+		const float DeltaTime) const;
+
+	// Restrict a run to some target bones: the bones of the listed target chains and the listed bones, plus all their parents.
+	// Chains without a masked bone are not encoded or decoded and non retargeted bones outside the mask are not updated.
+	// @param ChainNames - target chain names, see FRetargetChainPair::TargetBoneChainName
+	// @param BoneNames - target bone names
+	// @return false if a name is unknown, OutMask is left empty then
+	bool InitializeBoneMask(
+		const TArray<FName>& ChainNames,
+		const TArray<FName>& BoneNames,
+		FRetargetBoneMask& OutMask,
+		FIKRigLogger& Log) const;
+
+	// Same as above for the masked bones only, the IK and pole vector stages are not run.
+	// Masked and full runs can be mixed on one Context.
+	// @param Mask - from InitializeBoneMask() of this plan
+	// @param OutMaskedGlobalPose - receives the Component/Global space pose of Mask.BoneIndices
+	void RunRetargeter(
+		FRetargetContext& Context,
+		const FRetargetBoneMask& Mask,
+		const TArray<FTransform>& InSourceGlobalPose,
+		TArray<FTransform>& OutMaskedGlobalPose,
+		const std::unordered_map<FName, float>& SpeedValuesFromCurves,
+		const float DeltaTime) const;
+
+	bool bIsInitialized = false;
+	bool bRootsInitialized = false;
+	bool bAtLeastOneValidBoneChainPair = false;
+	bool bIKRigInitialized = false;
+	bool bDualQuatPoses = false;
+	UIKRetargeter* RetargeterAsset = nullptr;
+
+	// stages run every frame, fixed by GlobalSettings and what could be initialized
+	bool bRunRoot = false;
+	bool bRunFK = false;
+
+	// data structure for retarget
+	FRootRetargeter RootRetargeter;
+	FRetargetSkeleton SourceSkeleton;
+	FTargetSkeleton TargetSkeleton;
+	TArray<FRetargetChainPairFK> ChainPairsFK;
+	TArray<FRetargetChainPairIK> ChainPairsIK;
+
+	// per ChainPairsFK, the chains each one waits for, only filled with GlobalSettings.bParallelFKChains
+	FTaskGraph ChainGraphFK;
+	//TObjectPtr<UIKRigProcessor> IKRigProcessor = nullptr;
+
+	// setting
+	FRetargetGlobalSettings GlobalSettings;
+
+private:
+
+	// init
+	bool InitializeRoots(FIKRigLogger& Log);
+	bool InitializeBoneChainPairs(FIKRigLogger& Log);
+	bool InitializeIKRig(UObject* Outer, const USkeleton* InSkeleton);
+	void InitializeChainGraphFK();
+	
+	// run
+	void ResetOutputPose(TArray<FTransform>& OutputGlobalPose, const bool bFullUpdate) const;
+	void UpdateBelowRoot(FRetargetContext& Context, TArray<FTransform>& OutputGlobalPose, const bool bFullUpdate) const;
+	void UpdateNonRetargetedBones(TArray<FTransform>& OutputGlobalPose, const bool bFullUpdate) const;
+	void RunRootRetarget(FRetargetContext& Context, const TArray<FTransform>& InGlobalTransforms, TArray<FTransform>& OutGlobalTransforms) const;
+	void RunFKRetarget(FRetargetContext& Context, const TArray<FTransform>& InGlobalTransforms, TArray<FTransform>& OutGlobalTransforms) const;
+	void RunFKChain(FRetargetContext& Context, const int32_t ChainIndex, const TArray<FTransform>& InGlobalTransforms, TArray<FTransform>& OutGlobalTransforms) const;
+	void RunIKRetarget(
+		FRetargetContext& Context,
+		const TArray<FTransform>& InSourceGlobalPose,
+		TArray<FTransform>& OutTargetGlobalPose,
+		const std::unordered_map<FName, float>& SpeedValuesFromCurves,
+		const float DeltaTime) const;
+	void RunPoleVectorMatching(FRetargetContext& Context, const TArray<FTransform>& InGlobalTransforms, TArray<FTransform>& OutGlobalTransforms) const;
+	// Runs in the after the base IK retarget to apply stride warping to IK goals.
+	void RunStrideWarping(FRetargetContext& Context, const TArray<FTransform>& InTargeGlobalPose) const;
+
+	// log the first invalid bone, no-op when validation is compiled out
+	void ValidatePose(FRetargetContext& Context, const TArray<FTransform>& Pose, const FRetargetSkeleton& Skeleton, const char* Stage) const;
+};
+
+
+// single threaded front end: one plan and one context
 class UIKRetargetProcessor : public UObject
 {
 public:
@@ -469,6 +767,9 @@ public:
 		UIKRetargeter* InRetargeterAsset,
 		const bool bSuppressWarnings=false);
 
+	// Run an already initialized plan, ie. one shared through FRetargetPlanCache (SoulRetargetPlanCache.h).
+	void Initialize(std::shared_ptr<const FRetargetPlan> InPlan);
+
 	
 	// Run the retarget to generate a new pose.
 	// @param InSourceGlobalPose -  is the source mesh input pose in Component/Global space
@@ -478,46 +779,61 @@ public:
 		const std::unordered_map<FName, float>& SpeedValuesFromCurves,
 		const float DeltaTime);
 
-	// logging system
-	FIKRigLogger Log;
+	// Same as above into a pose the caller keeps between runs, see FRetargetPlan::RunRetargeter
+	void RunRetargeter(
+		const TArray<FTransform>& InSourceGlobalPose,
+		TArray<FTransform>& OutTargetGlobalPose,
+		const std::unordered_map<FName, float>& SpeedValuesFromCurves,
+		const float DeltaTime,
+		const bool bReuseOutputPose = false);
 
-private:
+	// Same as above with SoA poses (SoulPoseSoA.h).
+	// @param InSourceGlobalPose -  is the source mesh input pose in Component/Global space
+	// @param OutTargetGlobalPose - receives the retargeted Component/Global space pose for the target skeleton
+	void RunRetargeter(
+		const FPoseSoA& InSourceGlobalPose,
+		FPoseSoA& OutTargetGlobalPose,
+		const std::unordered_map<FName, float>& SpeedValuesFromCurves,
+		const float DeltaTime);
 
-	// init
-	bool InitializeRoots();
-	bool InitializeBoneChainPairs();
-	bool InitializeIKRig(UObject* Outer, const USkeleton* InSkeleton);
-	
-	// run
-	void RunRootRetarget(const TArray<FTransform>& InGlobalTransforms, TArray<FTransform>& OutGlobalTransforms);
-	void RunFKRetarget(const TArray<FTransform>& InGlobalTransforms, TArray<FTransform>& OutGlobalTransforms);
-	void RunIKRetarget(
+	// retarget a clip, see FRetargetPlan::RunRetargeterBatch
+	void RunRetargeterBatch(
+		const FTransform* InSourceGlobalPoses,
+		const int32_t NumFrames,
+		FTransform* OutTargetGlobalPoses,
+		const std::unordered_map<FName, float>& SpeedValuesFromCurves,
+		const float DeltaTime);
+
+	// retarget only part of the target skeleton, see FRetargetPlan::InitializeBoneMask
+	// a mask is built for the current plan, build it again after Initialize()
+	bool InitializeBoneMask(
+		const TArray<FName>& ChainNames,
+		const TArray<FName>& BoneNames,
+		FRetargetBoneMask& OutMask);
+
+	// @param OutMaskedGlobalPose - receives the Component/Global space pose of Mask.BoneIndices
+	void RunRetargeter(
+		const FRetargetBoneMask& Mask,
 		const TArray<FTransform>& InSourceGlobalPose,
-		TArray<FTransform>& OutTargetGlobalPose,
+		TArray<FTransform>& OutMaskedGlobalPose,
 		const std::unordered_map<FName, float>& SpeedValuesFromCurves,
 		const float DeltaTime);
-	void RunPoleVectorMatching(const TArray<FTransform>& InGlobalTransforms, TArray<FTransform>& OutGlobalTransforms);
-	// Runs in the after the base IK retarget to apply stride warping to IK goals.
-	void RunStrideWarping(const TArray<FTransform>& InTargeGlobalPose);
 
-private:
+	// the compiled plan, run it from other threads with one FRetargetContext each
+	// Initialize() builds a new plan, contexts initialized with the old one keep it alive
+	std::shared_ptr<const FRetargetPlan> GetPlan() const { return Plan; }
 
-	bool bIsInitialized = false;
-	bool bRootsInitialized = false;
-	bool bAtLeastOneValidBoneChainPair = false;
-	bool bIKRigInitialized = false;
-	UIKRetargeter* RetargeterAsset = nullptr;
+	// logging system
+	FIKRigLogger Log;
 
-	// data structure for retarget
-	FRootRetargeter RootRetargeter;
-	FRetargetSkeleton SourceSkeleton;
-	FTargetSkeleton TargetSkeleton;
-	TArray<FRetargetChainPairFK> ChainPairsFK;
-	TArray<FRetargetChainPairIK> ChainPairsIK;
-	//TObjectPtr<UIKRigProcessor> IKRigProcessor = nullptr;
+	// pose checks between retarget stages, compiled out unless IKRIG_VALIDATE_POSES
+	// frame advances once per RunRetargeter call, callers may SetFrame() to use their own numbering
+	FPoseValidator& GetPoseValidator() { return Context.PoseValidator; }
 
-	// setting
-	FRetargetGlobalSettings GlobalSettings;
+private:
+
+	std::shared_ptr<const FRetargetPlan> Plan;
+	FRetargetContext Context;
 };
 
 }
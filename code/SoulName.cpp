@@ -0,0 +1,76 @@
+//
+//  SoulName.cpp
+//
+//  interned names: 32 bit handle into a global name table
+//
+
+#include "SoulName.h"
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace SoulIK
+{
+    namespace
+    {
+        // deque keeps references stable while the table grows
+        struct FNameTable
+        {
+            std::mutex Mutex;
+            std::deque<std::string> Names;
+            std::unordered_map<std::string, uint32_t> Indices;
+
+            FNameTable()
+            {
+                Names.emplace_back();
+                Indices.emplace(std::string(), 0);
+            }
+
+            uint32_t Intern(const std::string& Name)
+            {
+                if (Name.empty())
+                {
+                    return 0;
+                }
+                std::lock_guard<std::mutex> Lock(Mutex);
+                auto It = Indices.find(Name);
+                if (It != Indices.end())
+                {
+                    return It->second;
+                }
+                const uint32_t Index = (uint32_t)Names.size();
+                Names.push_back(Name);
+                Indices.emplace(Name, Index);
+                return Index;
+            }
+
+            const std::string& Get(uint32_t Index)
+            {
+                std::lock_guard<std::mutex> Lock(Mutex);
+                return Names[Index];
+            }
+        };
+
+        FNameTable& GetNameTable()
+        {
+            static FNameTable Table;
+            return Table;
+        }
+    }
+
+    FName::FName(const char* InName)
+        : Index(InName ? GetNameTable().Intern(InName) : 0)
+    {
+    }
+
+    FName::FName(const std::string& InName)
+        : Index(GetNameTable().Intern(InName))
+    {
+    }
+
+    const std::string& FName::ToString() const
+    {
+        return GetNameTable().Get(Index);
+    }
+}
@@ -0,0 +1,51 @@
+//
+//  SoulName.h
+//
+//  interned names: 32 bit handle into a global name table
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <functional>
+
+namespace SoulIK
+{
+    // like UE FName: equal strings share one handle, compare / hash as an integer
+    // constructing from a string interns it (one hashed lookup under a lock), do that at init, not per frame
+    // handle 0 is the empty string, NAME_None
+    class FName
+    {
+    public:
+        FName() = default;
+        FName(const char* InName);
+        FName(const std::string& InName);
+
+        const std::string& ToString() const;
+        const char* c_str() const { return ToString().c_str(); }
+
+        uint32_t GetIndex() const { return Index; }
+        bool IsNone() const { return Index == 0; }
+
+        bool operator==(const FName& Other) const { return Index == Other.Index; }
+        bool operator!=(const FName& Other) const { return Index != Other.Index; }
+        // handle order, not alphabetical
+        bool operator<(const FName& Other) const { return Index < Other.Index; }
+
+    private:
+        uint32_t Index = 0;
+    };
+}
+
+namespace std
+{
+    template<>
+    struct hash<SoulIK::FName>
+    {
+        size_t operator()(const SoulIK::FName& Name) const noexcept
+        {
+            return std::hash<uint32_t>()(Name.GetIndex());
+        }
+    };
+}
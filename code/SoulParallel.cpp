@@ -0,0 +1,366 @@
+//
+//  SoulParallel.cpp
+//
+//  fork-join parallel for and task graphs over a small persistent worker pool
+//
+
+#include "SoulParallel.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace SoulIK;
+
+namespace
+{
+    // ready tasks of one thread during a ParallelForGraph, the owner pushes and pops at the back,
+    // the other threads steal from the front, so a chain of dependents tends to stay on one thread
+    struct FTaskQueue
+    {
+        std::mutex Mutex;
+        TArray<int32> Tasks;    // a task is pushed once per run, so one slot per graph task never runs out
+        int32 Head = 0;
+        int32 Tail = 0;
+
+        void Push(int32 Task)
+        {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            Tasks[Tail++] = Task;
+        }
+
+        bool Pop(int32& OutTask)
+        {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            if (Head == Tail)
+            {
+                return false;
+            }
+            OutTask = Tasks[--Tail];
+            return true;
+        }
+
+        bool Steal(int32& OutTask)
+        {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            if (Head == Tail)
+            {
+                return false;
+            }
+            OutTask = Tasks[Head++];
+            return true;
+        }
+    };
+
+    // every worker takes part in every job, so the caller knows all of them are done with it
+    // once Pending drops to zero and the job can go out of scope
+    class FWorkerPool
+    {
+    public:
+        using FJob = TFunctionRef<void(int32 Thread)>;
+
+        static FWorkerPool& Get()
+        {
+            static FWorkerPool Pool;
+            return Pool;
+        }
+
+        ~FWorkerPool()
+        {
+            std::lock_guard<std::mutex> RunLock(RunMutex);
+            Resize(0);
+        }
+
+        // held for a whole ParallelFor, ParallelForGraph or Resize
+        std::mutex RunMutex;
+
+        int32 Num() const { return (int32)Threads.size(); }
+
+        // RunMutex must be held
+        void Resize(int32 Count)
+        {
+            {
+                std::lock_guard<std::mutex> Lock(Mutex);
+                bStop = true;
+            }
+            WakeCondition.notify_all();
+            for (std::thread& Thread : Threads)
+            {
+                Thread.join();
+            }
+            Threads.clear();
+
+            // one queue per worker and one for the calling thread
+            Queues.reset(new FTaskQueue[Count + 1]);
+            QueueCapacity = 0;
+
+            // a thread that starts late must still see the next job as new
+            bStop = false;
+            const uint64_t StartGeneration = Generation;
+            Threads.reserve(Count);
+            for (int32 Index = 0; Index < Count; ++Index)
+            {
+                Threads.emplace_back([this, Index, StartGeneration]() { WorkerLoop(Index + 1, StartGeneration); });
+            }
+        }
+
+        // runs InJob once on every worker and once on the calling thread, which is thread 0
+        // RunMutex must be held
+        void Run(const FJob& InJob)
+        {
+            {
+                std::lock_guard<std::mutex> Lock(Mutex);
+                Job = &InJob;
+                Pending = Num();
+                ++Generation;
+            }
+            WakeCondition.notify_all();
+
+            InJob(0);
+
+            std::unique_lock<std::mutex> Lock(Mutex);
+            DoneCondition.wait(Lock, [this]() { return Pending == 0; });
+            Job = nullptr;
+        }
+
+        // RunMutex must be held
+        void RunGraph(const FTaskGraph& Graph, const TFunctionRef<void(int32)>& Body)
+        {
+            // scratch only grows, so running the same graph again allocates nothing
+            const int32 NumTasks = Graph.Num();
+            if (QueueCapacity < NumTasks)
+            {
+                for (int32 Thread = 0; Thread <= Num(); ++Thread)
+                {
+                    Queues[Thread].Tasks.resize(NumTasks);
+                }
+                QueueCapacity = NumTasks;
+            }
+            if (DependencyCapacity < NumTasks)
+            {
+                PendingDependencies.reset(new std::atomic<int32>[NumTasks]);
+                DependencyCapacity = NumTasks;
+            }
+
+            for (int32 Task = 0; Task < NumTasks; ++Task)
+            {
+                PendingDependencies[Task].store(Graph.NumDependencies[Task], std::memory_order_relaxed);
+            }
+            for (int32 Thread = 0; Thread <= Num(); ++Thread)
+            {
+                Queues[Thread].Head = 0;
+                Queues[Thread].Tail = 0;
+            }
+            for (const int32 Task : Graph.Roots)
+            {
+                Queues[0].Tasks[Queues[0].Tail++] = Task;
+            }
+            RemainingTasks.store(NumTasks, std::memory_order_relaxed);
+
+            // published to the workers by the lock in Run
+            const auto GraphTasks = [&](int32 Thread) { RunGraphTasks(Graph, Body, Thread); };
+            Run(GraphTasks);
+        }
+
+    private:
+        FWorkerPool()
+        {
+            const int32 Hardware = (int32)std::thread::hardware_concurrency();
+            std::lock_guard<std::mutex> RunLock(RunMutex);
+            Resize(std::max(Hardware - 1, 0));
+        }
+
+        void RunGraphTasks(const FTaskGraph& Graph, const TFunctionRef<void(int32)>& Body, int32 Thread)
+        {
+            FTaskQueue& Own = Queues[Thread];
+            int32 Task = INDEX_NONE;
+            while (RemainingTasks.load(std::memory_order_acquire) > 0)
+            {
+                if (!Own.Pop(Task) && !StealTask(Thread, Task))
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                Body(Task);
+
+                // the last dependency to finish queues the dependent, its acquire sees every write of the others
+                for (int32 Slot = Graph.DependentOffsets[Task]; Slot < Graph.DependentOffsets[Task + 1]; ++Slot)
+                {
+                    const int32 Dependent = Graph.Dependents[Slot];
+                    if (PendingDependencies[Dependent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    {
+                        Own.Push(Dependent);
+                    }
+                }
+                RemainingTasks.fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        bool StealTask(int32 Thread, int32& OutTask)
+        {
+            const int32 NumQueues = Num() + 1;
+            for (int32 Offset = 1; Offset < NumQueues; ++Offset)
+            {
+                if (Queues[(Thread + Offset) % NumQueues].Steal(OutTask))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void WorkerLoop(int32 Thread, uint64_t Seen)
+        {
+            std::unique_lock<std::mutex> Lock(Mutex);
+            while (true)
+            {
+                WakeCondition.wait(Lock, [this, Seen]() { return bStop || Generation != Seen; });
+                if (bStop)
+                {
+                    return;
+                }
+                Seen = Generation;
+                const FJob* InJob = Job;
+                Lock.unlock();
+
+                (*InJob)(Thread);
+
+                Lock.lock();
+                if (--Pending == 0)
+                {
+                    DoneCondition.notify_all();
+                }
+            }
+        }
+
+        std::vector<std::thread> Threads;
+        std::mutex Mutex;
+        std::condition_variable WakeCondition;
+        std::condition_variable DoneCondition;
+        const FJob* Job = nullptr;
+        int32 Pending = 0;
+        uint64_t Generation = 0;
+        bool bStop = false;
+
+        // ParallelForGraph scratch
+        std::unique_ptr<FTaskQueue[]> Queues;
+        int32 QueueCapacity = 0;
+        std::unique_ptr<std::atomic<int32>[]> PendingDependencies;
+        int32 DependencyCapacity = 0;
+        std::atomic<int32> RemainingTasks{0};
+    };
+}
+
+namespace SoulIK
+{
+    void ParallelFor(int32 Num, int32 MinBatchSize, TFunctionRef<void(int32 Begin, int32 End)> Body)
+    {
+        if (Num <= 0)
+        {
+            return;
+        }
+
+        FWorkerPool& Pool = FWorkerPool::Get();
+        const int32 MaxChunks = Num / std::max(MinBatchSize, 1);
+        std::unique_lock<std::mutex> RunLock(Pool.RunMutex, std::defer_lock);
+        if (MaxChunks < 2 || Pool.Num() == 0 || !RunLock.try_lock())
+        {
+            Body(0, Num);
+            return;
+        }
+
+        // a few chunks per thread to even out uneven work
+        const int32 NumChunks = std::min(MaxChunks, (Pool.Num() + 1) * 4);
+        std::atomic<int32> NextChunk{0};
+        const auto Chunks = [&](int32 Thread)
+        {
+            for (int32 Chunk = NextChunk.fetch_add(1); Chunk < NumChunks; Chunk = NextChunk.fetch_add(1))
+            {
+                const int32 Begin = (int32)((int64_t)Num * Chunk / NumChunks);
+                const int32 End = (int32)((int64_t)Num * (Chunk + 1) / NumChunks);
+                Body(Begin, End);
+            }
+        };
+        Pool.Run(Chunks);
+    }
+
+    bool FTaskGraph::Initialize(const TArray<TArray<int32>>& Dependencies)
+    {
+        Reset();
+        const int32 NumTasks = (int32)Dependencies.size();
+        NumDependencies.resize(NumTasks, 0);
+        DependentOffsets.resize(NumTasks + 1, 0);
+        for (int32 Task = 0; Task < NumTasks; ++Task)
+        {
+            for (const int32 Dependency : Dependencies[Task])
+            {
+                if (Dependency < 0 || Dependency >= Task)
+                {
+                    Reset();
+                    return false;
+                }
+                ++NumDependencies[Task];
+                ++DependentOffsets[Dependency + 1];
+            }
+            if (NumDependencies[Task] == 0)
+            {
+                Roots.push_back(Task);
+            }
+        }
+
+        for (int32 Task = 0; Task < NumTasks; ++Task)
+        {
+            DependentOffsets[Task + 1] += DependentOffsets[Task];
+        }
+        Dependents.resize(DependentOffsets[NumTasks]);
+        TArray<int32> Filled(DependentOffsets.begin(), DependentOffsets.end() - 1);
+        for (int32 Task = 0; Task < NumTasks; ++Task)
+        {
+            for (const int32 Dependency : Dependencies[Task])
+            {
+                Dependents[Filled[Dependency]++] = Task;
+            }
+        }
+        return true;
+    }
+
+    void FTaskGraph::Reset()
+    {
+        NumDependencies.clear();
+        DependentOffsets.clear();
+        Dependents.clear();
+        Roots.clear();
+    }
+
+    void ParallelForGraph(const FTaskGraph& Graph, TFunctionRef<void(int32 Task)> Body)
+    {
+        const int32 NumTasks = Graph.Num();
+        FWorkerPool& Pool = FWorkerPool::Get();
+        std::unique_lock<std::mutex> RunLock(Pool.RunMutex, std::defer_lock);
+        if (NumTasks < 2 || Pool.Num() == 0 || !RunLock.try_lock())
+        {
+            for (int32 Task = 0; Task < NumTasks; ++Task)
+            {
+                Body(Task);
+            }
+            return;
+        }
+
+        Pool.RunGraph(Graph, Body);
+    }
+
+    int32 GetParallelWorkerCount()
+    {
+        FWorkerPool& Pool = FWorkerPool::Get();
+        std::lock_guard<std::mutex> RunLock(Pool.RunMutex);
+        return Pool.Num();
+    }
+
+    void SetParallelWorkerCount(int32 Count)
+    {
+        FWorkerPool& Pool = FWorkerPool::Get();
+        std::lock_guard<std::mutex> RunLock(Pool.RunMutex);
+        Pool.Resize(std::max(Count, 0));
+    }
+}
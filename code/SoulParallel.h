@@ -0,0 +1,78 @@
+//
+//  SoulParallel.h
+//
+//  fork-join parallel for and task graphs over a small persistent worker pool
+//
+
+#pragma once
+
+#include "SoulFTransform.h"
+#include <type_traits>
+
+namespace SoulIK
+{
+    template<typename FuncType>
+    class TFunctionRef;
+
+    // non-owning reference to a callable, only valid while the callable lives, ie. a lambda passed to ParallelFor
+    // unlike std::function it never allocates, whatever the lambda captures
+    template<typename RetType, typename... ArgTypes>
+    class TFunctionRef<RetType(ArgTypes...)>
+    {
+    public:
+        template<typename FunctorType, typename = std::enable_if_t<!std::is_same<std::decay_t<FunctorType>, TFunctionRef>::value>>
+        TFunctionRef(FunctorType&& Functor)
+            : Callable(const_cast<void*>(static_cast<const void*>(std::addressof(Functor))))
+            , Invoker(&Invoke<std::remove_reference_t<FunctorType>>)
+        {
+        }
+
+        RetType operator()(ArgTypes... Args) const
+        {
+            return Invoker(Callable, std::forward<ArgTypes>(Args)...);
+        }
+
+    private:
+        template<typename FunctorType>
+        static RetType Invoke(void* InCallable, ArgTypes... Args)
+        {
+            return (*static_cast<FunctorType*>(InCallable))(std::forward<ArgTypes>(Args)...);
+        }
+
+        void* Callable;
+        RetType (*Invoker)(void*, ArgTypes...);
+    };
+
+    // runs Body(Begin, End) over [0, Num) in chunks of at least MinBatchSize bones/items,
+    // on the worker threads and the calling thread, and returns once every chunk is done
+    // falls back to a single Body(0, Num) on the calling thread when there are less than two chunks,
+    // no workers, or the pool is already busy with another ParallelFor (nested or concurrent call)
+    void ParallelFor(int32 Num, int32 MinBatchSize, TFunctionRef<void(int32 Begin, int32 End)> Body);
+
+    // tasks with the tasks they wait for, built once and run any number of times by ParallelForGraph
+    // every dependency of a task has a lower index, so running the tasks in index order is always valid
+    struct FTaskGraph
+    {
+        // @param Dependencies - per task, indices of the tasks it waits for, each lower than its own
+        // @return false if a dependency is out of range, the graph is left empty then
+        bool Initialize(const TArray<TArray<int32>>& Dependencies);
+        void Reset();
+
+        int32 Num() const { return (int32)NumDependencies.size(); }
+
+        TArray<int32> NumDependencies;  // per task
+        TArray<int32> DependentOffsets;  // per task + 1, its range in Dependents
+        TArray<int32> Dependents;       // tasks waiting for the task, by task
+        TArray<int32> Roots;            // tasks without dependencies
+    };
+
+    // runs Body(Task) for every task of Graph, each one after all its dependencies are done, and returns once all are done
+    // ready tasks are kept per thread, a thread that runs out takes the oldest ready task of another one
+    // falls back to index order on the calling thread in the same cases as ParallelFor
+    void ParallelForGraph(const FTaskGraph& Graph, TFunctionRef<void(int32 Task)> Body);
+
+    // worker threads besides the calling thread, std::thread::hardware_concurrency() - 1 by default
+    // 0 runs every ParallelFor and ParallelForGraph inline, changing it waits for a running one to finish
+    int32 GetParallelWorkerCount();
+    void SetParallelWorkerCount(int32 Count);
+}
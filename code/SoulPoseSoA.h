@@ -0,0 +1,100 @@
+//
+//  SoulPoseSoA.h
+//
+//  pose stored as separate rotation / translation / scale arrays
+//
+
+#pragma once
+
+#include <new>
+#include <cstddef>
+#include "SoulFTransform.h"
+
+namespace SoulIK
+{
+    // std allocator returning Alignment aligned blocks, so SIMD loads of a component array never split a cache line
+    template<typename T, std::size_t Alignment>
+    struct TAlignedAllocator
+    {
+        using value_type = T;
+
+        template<typename U>
+        struct rebind { using other = TAlignedAllocator<U, Alignment>; };
+
+        TAlignedAllocator() = default;
+        template<typename U>
+        TAlignedAllocator(const TAlignedAllocator<U, Alignment>&) {}
+
+        T* allocate(std::size_t Num)
+        {
+            return static_cast<T*>(::operator new(Num * sizeof(T), std::align_val_t(Alignment)));
+        }
+        void deallocate(T* Ptr, std::size_t)
+        {
+            ::operator delete(Ptr, std::align_val_t(Alignment));
+        }
+
+        template<typename U>
+        bool operator==(const TAlignedAllocator<U, Alignment>&) const { return true; }
+        template<typename U>
+        bool operator!=(const TAlignedAllocator<U, Alignment>&) const { return false; }
+    };
+
+    template<typename T>
+    using TAlignedArray = std::vector<T, TAlignedAllocator<T, 32>>;
+
+    // SoA counterpart of TArray<FTransform>
+    // index i of each array is bone i; passes touching one component (eg. rotation only) read one contiguous array
+    template<typename T>
+    struct TPoseSoA
+    {
+        TAlignedArray<TQuat<T>> Rotations;
+        TAlignedArray<TVector<T>> Translations;
+        TAlignedArray<TVector<T>> Scales;
+
+        int32 Num() const
+        {
+            return (int32)Rotations.size();
+        }
+
+        void SetNum(int32 InNum)
+        {
+            Rotations.resize(InNum);
+            Translations.resize(InNum);
+            Scales.resize(InNum, TVector<T>::OneVector);
+        }
+
+        TTransform<T> GetTransform(int32 Index) const
+        {
+            return TTransform<T>(Rotations[Index], Translations[Index], Scales[Index]);
+        }
+
+        void SetTransform(int32 Index, const TTransform<T>& InTransform)
+        {
+            Rotations[Index] = InTransform.Rotation;
+            Translations[Index] = InTransform.Translation;
+            Scales[Index] = InTransform.Scale3D;
+        }
+
+        // adapters to/from AoS poses
+        void CopyFrom(const TArray<TTransform<T>>& InPose)
+        {
+            SetNum((int32)InPose.size());
+            for (int32 Index = 0; Index < InPose.size(); ++Index)
+            {
+                SetTransform(Index, InPose[Index]);
+            }
+        }
+
+        void CopyTo(TArray<TTransform<T>>& OutPose) const
+        {
+            OutPose.resize(Num());
+            for (int32 Index = 0; Index < Num(); ++Index)
+            {
+                OutPose[Index] = GetTransform(Index);
+            }
+        }
+    };
+
+    using FPoseSoA = TPoseSoA<FReal>;
+}
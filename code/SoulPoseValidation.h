@@ -0,0 +1,155 @@
+//
+//  SoulPoseValidation.h
+//
+//  whole-pose checks at retarget stage boundaries
+//
+
+#pragma once
+
+#include "SoulPoseSoA.h"
+
+// IKRIG_VALIDATE_POSES: 1 checks every pose between retarget stages, 0 compiles the checks out
+// defaults to on in debug builds, set it explicitly to override (see CMakeLists.txt)
+#ifndef IKRIG_VALIDATE_POSES
+    #ifdef NDEBUG
+        #define IKRIG_VALIDATE_POSES 0
+    #else
+        #define IKRIG_VALIDATE_POSES 1
+    #endif
+#endif
+
+namespace SoulIK
+{
+    enum class EPoseError : uint8_t
+    {
+        None,
+        NonFinite,              // nan or inf in any component
+        UnnormalizedRotation,
+        NegativeScale,
+    };
+
+    inline const char* PoseErrorToString(EPoseError Error)
+    {
+        switch (Error)
+        {
+            case EPoseError::None: return "None";
+            case EPoseError::NonFinite: return "NonFinite";
+            case EPoseError::UnnormalizedRotation: return "UnnormalizedRotation";
+            case EPoseError::NegativeScale: return "NegativeScale";
+        }
+        return "Unknown";
+    }
+
+    struct FPoseValidationError
+    {
+        EPoseError Error = EPoseError::None;
+        int32 BoneIndex = INDEX_NONE;
+        int32 Frame = INDEX_NONE;
+        const char* Stage = "";
+    };
+
+    template<typename T>
+    inline EPoseError ValidateTransform(const TQuat<T>& Rotation, const TVector<T>& Translation, const TVector<T>& Scale3D)
+    {
+        const bool bFinite =
+            std::isfinite(Rotation.x) && std::isfinite(Rotation.y) && std::isfinite(Rotation.z) && std::isfinite(Rotation.w) &&
+            std::isfinite(Translation.x) && std::isfinite(Translation.y) && std::isfinite(Translation.z) &&
+            std::isfinite(Scale3D.x) && std::isfinite(Scale3D.y) && std::isfinite(Scale3D.z);
+        if (!bFinite)
+        {
+            return EPoseError::NonFinite;
+        }
+        if (!Rotation.IsNormalized())
+        {
+            return EPoseError::UnnormalizedRotation;
+        }
+        if (Scale3D.x < 0 || Scale3D.y < 0 || Scale3D.z < 0)
+        {
+            return EPoseError::NegativeScale;
+        }
+        return EPoseError::None;
+    }
+
+    // validation policy:
+    //   TPoseValidator<true> checks whole poses and keeps the first failure (bone, frame, stage) until Reset()
+    //   TPoseValidator<false> is empty, every call compiles away
+    template<bool bEnabled>
+    struct TPoseValidator
+    {
+        FPoseValidationError FirstError;
+        int32 Frame = INDEX_NONE;
+
+        void SetFrame(int32 InFrame) { Frame = InFrame; }
+        void NextFrame() { ++Frame; }
+        int32 GetFrame() const { return Frame; }
+        bool HasError() const { return FirstError.Error != EPoseError::None; }
+
+        void Reset()
+        {
+            FirstError = FPoseValidationError();
+            Frame = INDEX_NONE;
+        }
+
+        // @return false if any bone of the pose is invalid
+        template<typename T>
+        bool Validate(const TArray<TTransform<T>>& Pose, const char* Stage)
+        {
+            for (int32 BoneIndex = 0; BoneIndex < Pose.size(); ++BoneIndex)
+            {
+                const TTransform<T>& Transform = Pose[BoneIndex];
+                const EPoseError Error = ValidateTransform(Transform.Rotation, Transform.Translation, Transform.Scale3D);
+                if (Error != EPoseError::None)
+                {
+                    Record(Error, BoneIndex, Stage);
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template<typename T>
+        bool Validate(const TPoseSoA<T>& Pose, const char* Stage)
+        {
+            for (int32 BoneIndex = 0; BoneIndex < Pose.Num(); ++BoneIndex)
+            {
+                const EPoseError Error = ValidateTransform(Pose.Rotations[BoneIndex], Pose.Translations[BoneIndex], Pose.Scales[BoneIndex]);
+                if (Error != EPoseError::None)
+                {
+                    Record(Error, BoneIndex, Stage);
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    private:
+        void Record(EPoseError Error, int32 BoneIndex, const char* Stage)
+        {
+            if (HasError())
+            {
+                return;
+            }
+            FirstError.Error = Error;
+            FirstError.BoneIndex = BoneIndex;
+            FirstError.Frame = Frame;
+            FirstError.Stage = Stage;
+        }
+    };
+
+    template<>
+    struct TPoseValidator<false>
+    {
+        FPoseValidationError FirstError;
+
+        void SetFrame(int32) {}
+        void NextFrame() {}
+        int32 GetFrame() const { return INDEX_NONE; }
+        bool HasError() const { return false; }
+        void Reset() {}
+
+        template<typename PoseType>
+        bool Validate(const PoseType&, const char*) { return true; }
+    };
+
+    using FPoseValidator = TPoseValidator<IKRIG_VALIDATE_POSES != 0>;
+}
@@ -0,0 +1,141 @@
+//
+//  SoulRetargetPlanCache.cpp
+//
+//  compiled retarget plans shared by content hash of the skeletons and config they were built from
+//
+
+#include "SoulRetargetPlanCache.h"
+
+#include <algorithm>
+
+using namespace SoulIK;
+
+void FContentHash::AddBytes(const void* Data, size_t Size)
+{
+    const uint8_t* Bytes = static_cast<const uint8_t*>(Data);
+    for (size_t Index = 0; Index < Size; ++Index)
+    {
+        Hash = (Hash ^ Bytes[Index]) * 1099511628211ull;
+    }
+}
+
+void FContentHash::Add(const std::string& Value)
+{
+    // length first, so "ab" + "c" and "a" + "bc" differ
+    Add((uint64_t)Value.size());
+    AddBytes(Value.data(), Value.size());
+}
+
+void FContentHash::Add(const FTransform& Value)
+{
+    for (const FReal Component : {
+        Value.Rotation.x, Value.Rotation.y, Value.Rotation.z, Value.Rotation.w,
+        Value.Translation.x, Value.Translation.y, Value.Translation.z,
+        Value.Scale3D.x, Value.Scale3D.y, Value.Scale3D.z})
+    {
+        Add(Component);
+    }
+}
+
+void FContentHash::Add(const USkeleton& Value)
+{
+    Add((uint64_t)Value.boneTree.size());
+    for (const FBoneNode& Bone : Value.boneTree)
+    {
+        Add(Bone.name);
+        Add(Bone.parent);
+    }
+    Add((uint64_t)Value.refpose.size());
+    for (const FTransform& Transform : Value.refpose)
+    {
+        Add(Transform);
+    }
+}
+
+namespace
+{
+    // the plan keeps raw pointers to its skeletons and asset, they live next to it
+    struct FCachedPlan
+    {
+        USkeleton SourceSkeleton;
+        USkeleton TargetSkeleton;
+        std::shared_ptr<UIKRetargeter> Asset;
+        FRetargetPlan Plan;
+    };
+}
+
+FRetargetPlanCache& FRetargetPlanCache::Get()
+{
+    static FRetargetPlanCache Cache;
+    return Cache;
+}
+
+std::shared_ptr<const FRetargetPlan> FRetargetPlanCache::FindOrCreate(
+    uint64_t Key,
+    const USkeleton& SourceSkeleton,
+    const USkeleton& TargetSkeleton,
+    const FCreateAsset& CreateAsset,
+    FIKRigLogger& Log)
+{
+    if (std::shared_ptr<const FRetargetPlan> Plan = Find(Key))
+    {
+        return Plan;
+    }
+
+    // initialized outside the lock, two threads missing the same key both build and the first one is kept
+    std::shared_ptr<FCachedPlan> Cached = std::make_shared<FCachedPlan>();
+    Cached->SourceSkeleton = SourceSkeleton;
+    Cached->TargetSkeleton = TargetSkeleton;
+    Cached->Asset = CreateAsset(Cached->SourceSkeleton, Cached->TargetSkeleton);
+    Cached->Plan.Initialize(&Cached->SourceSkeleton, &Cached->TargetSkeleton, Cached->Asset.get(), Log);
+    std::shared_ptr<const FRetargetPlan> Plan(Cached, &Cached->Plan);
+    if (!Plan->bIsInitialized)
+    {
+        return Plan;
+    }
+
+    std::lock_guard<std::mutex> Lock(Mutex);
+    auto It = std::find_if(Entries.begin(), Entries.end(), [Key](const auto& Entry) { return Entry.first == Key; });
+    if (It != Entries.end())
+    {
+        return It->second;
+    }
+    if (MaxNum > 0)
+    {
+        Entries.emplace_back(Key, Plan);
+        while (Entries.size() > MaxNum)
+        {
+            Entries.pop_front();
+        }
+    }
+    return Plan;
+}
+
+std::shared_ptr<const FRetargetPlan> FRetargetPlanCache::Find(uint64_t Key) const
+{
+    std::lock_guard<std::mutex> Lock(Mutex);
+    auto It = std::find_if(Entries.begin(), Entries.end(), [Key](const auto& Entry) { return Entry.first == Key; });
+    return It != Entries.end() ? It->second : nullptr;
+}
+
+void FRetargetPlanCache::Clear()
+{
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Entries.clear();
+}
+
+int32 FRetargetPlanCache::Num() const
+{
+    std::lock_guard<std::mutex> Lock(Mutex);
+    return (int32)Entries.size();
+}
+
+void FRetargetPlanCache::SetMaxNum(int32 InMaxNum)
+{
+    std::lock_guard<std::mutex> Lock(Mutex);
+    MaxNum = InMaxNum > 0 ? (size_t)InMaxNum : 0;
+    while (Entries.size() > MaxNum)
+    {
+        Entries.pop_front();
+    }
+}
@@ -0,0 +1,76 @@
+//
+//  SoulRetargetPlanCache.h
+//
+//  compiled retarget plans shared by content hash of the skeletons and config they were built from
+//
+
+#pragma once
+
+#include "SoulIKRetargetProcessor.h"
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <type_traits>
+
+namespace SoulIK
+{
+    // 64 bit FNV-1a over the content, not the addresses, so equal inputs hash equal in every process
+    class FContentHash
+    {
+    public:
+        void AddBytes(const void* Data, size_t Size);
+
+        template<typename T>
+        void Add(const T& Value)
+        {
+            static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "hash members one by one");
+            AddBytes(&Value, sizeof(T));
+        }
+
+        void Add(const std::string& Value);
+        void Add(const FName& Value) { Add(Value.ToString()); }
+        void Add(const FTransform& Value);
+        // bone names, parents and reference pose
+        void Add(const USkeleton& Value);
+
+        uint64_t Get() const { return Hash; }
+
+    private:
+        uint64_t Hash = 14695981039346656037ull;
+    };
+
+    // in-process cache of initialized FRetargetPlan, ie. one plan for a batch of clips on the same character pair
+    // an entry owns copies of the skeletons and the asset its plan points to, so callers may free their own
+    // a plan that fails to initialize is returned but not cached, a 64 bit key collision is not detected
+    class FRetargetPlanCache
+    {
+    public:
+        // build the asset of a new plan from the cached copies of the skeletons
+        using FCreateAsset = std::function<std::shared_ptr<UIKRetargeter>(USkeleton& SourceSkeleton, USkeleton& TargetSkeleton)>;
+
+        static FRetargetPlanCache& Get();
+
+        // @param Key - content hash of everything CreateAsset and the skeletons feed into the plan
+        // @return the cached plan for Key, or a new one initialized from copies of the skeletons and CreateAsset
+        std::shared_ptr<const FRetargetPlan> FindOrCreate(
+            uint64_t Key,
+            const USkeleton& SourceSkeleton,
+            const USkeleton& TargetSkeleton,
+            const FCreateAsset& CreateAsset,
+            FIKRigLogger& Log);
+
+        std::shared_ptr<const FRetargetPlan> Find(uint64_t Key) const;
+
+        // plans already handed out stay alive until their last user drops them
+        void Clear();
+        int32 Num() const;
+
+        // oldest entries are dropped beyond this, 0 (or less) disables caching
+        void SetMaxNum(int32 InMaxNum);
+
+    private:
+        mutable std::mutex Mutex;
+        std::deque<std::pair<uint64_t, std::shared_ptr<const FRetargetPlan>>> Entries;   // oldest first
+        size_t MaxNum = 16;   // unsigned like Entries.size(), SetMaxNum() clamps negative counts
+    };
+}
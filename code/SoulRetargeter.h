@@ -183,6 +183,17 @@ namespace SoulIK
         bool bEnableFK = true;
         bool bEnableIK = true;
         bool bWarping = false;
+        // hierarchy updates and FK chain encode/decode in unit dual quaternions (SoulDualQuat.h),
+        // only taken when neither skeleton has scale in its retarget pose,
+        // a source chain that has scale in a frame is encoded with FTransform math for that frame
+        bool bDualQuatPoses = false;
+        // target hierarchy updates level by level (FBoneLevels in SoulBoneHierarchy.h) instead of bone by bone,
+        // levels of at least ParallelLevelMinBones bones are split over the worker threads, INDEX_NONE keeps them on the caller
+        bool bLevelHierarchyUpdates = false;
+        int32_t ParallelLevelMinBones = 1024;
+        // FK chains that share no target bones are encoded/decoded at the same time on the worker threads,
+        // the result is the same as the serial run in start bone order
+        bool bParallelFKChains = false;
 
         EWarpingDirectionSource DirectionSource = EWarpingDirectionSource::Goals;
         EBasicAxis ForwardDirection = EBasicAxis::Y;
@@ -248,7 +259,7 @@ namespace SoulIK
         {
         }
 
-        std::string BoneName;
+        FName BoneName;
         int32_t BoneIndex : 31;
         uint32_t bUseSkeletonIndex : 1;
     };
@@ -266,7 +277,7 @@ namespace SoulIK
         FName ChainName;
         FBoneReference StartBone;
         FBoneReference EndBone;
-        std::string IKGoalName;
+        FName IKGoalName;
     };
 
     enum class ERootType: uint8_t {
@@ -278,9 +289,24 @@ namespace SoulIK
     {
     public:
         ERootType   RootType;
-        std::string RootBone;
-        std::string GroundBone;         // RootBone.z - GroundBone.z = height
+        FName RootBone;
+        FName GroundBone;               // RootBone.z - GroundBone.z = height
+
+        // chains are only set through SetBoneChains() so the name index never goes stale
+        void SetBoneChains(TArray<FBoneChain> InBoneChains)
+        {
+            BoneChains = std::move(InBoneChains);
+            ChainIndexByName.clear();
+            for (int32 ChainIndex = 0; ChainIndex < BoneChains.size(); ++ChainIndex)
+            {
+                ChainIndexByName.emplace(BoneChains[ChainIndex].ChainName, ChainIndex);
+            }
+        }
+        const TArray<FBoneChain>& GetBoneChains() const { return BoneChains; }
+
+    private:
         TArray<FBoneChain> BoneChains;
+        TMap<FName, int32> ChainIndexByName;
 
         friend class UIKRigDefinition;
     };
@@ -300,14 +326,8 @@ namespace SoulIK
         const ERootType GetRootType() const {return RetargetDefinition.RootType; }
         const FBoneChain* GetRetargetChainByName(FName ChainName) const
         {
-            for (const FBoneChain& Chain : RetargetDefinition.BoneChains)
-            {
-                if (Chain.ChainName == ChainName)
-                {
-                    return &Chain;
-                }
-            }
-            return nullptr;
+            auto It = RetargetDefinition.ChainIndexByName.find(ChainName);
+            return It == RetargetDefinition.ChainIndexByName.end() ? nullptr : &RetargetDefinition.BoneChains[It->second];
         }
 
     };
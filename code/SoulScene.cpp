@@ -6,6 +6,7 @@
 //
 
 #include "SoulScene.hpp"
+#include <cassert>
 
 using namespace SoulIK;
 
@@ -17,28 +18,97 @@ SoulTransform::SoulTransform(glm::mat4 const& m) {
     glm::decompose(m, scale, rotation, translation, skew, perspective);
 }
 
-static void Multiply(SoulTransform* OutTransform, const SoulTransform* A, const SoulTransform* B) {
-    // TODO: avoid decompose
+// closed form TRS math, same convention as glm: child_global = parent_global * child_local
+//   T(AxB) = T(A) + R(A)*(S(A)*T(B))
+//   R(AxB) = R(A)*R(B)
+//   S(AxB) = S(A)*S(B)
+// only exact when S(A) is uniform: a non-uniform parent scale shears the child, which the matrix path keeps
+// (folded into the decomposed rotation and scale) and the closed form can not, so that goes through the matrix,
+// as does negative scale, which flips handedness and can not be split into quat and scale
+
+static bool HasUniformPositiveScale(const glm::vec3& s) {
+    const float Tolerance = 1.e-5f * s.x;
+    return s.x > 0.f && s.y > 0.f && s.z > 0.f && std::abs(s.y - s.x) <= Tolerance && std::abs(s.z - s.x) <= Tolerance;
+}
+
+static glm::vec3 GetSafeScaleReciprocal(const glm::vec3& s) {
+    const float Tolerance = 1.e-8f;
+    return glm::vec3(
+        std::abs(s.x) <= Tolerance ? 0.f : 1.f / s.x,
+        std::abs(s.y) <= Tolerance ? 0.f : 1.f / s.y,
+        std::abs(s.z) <= Tolerance ? 0.f : 1.f / s.z);
+}
+
+static void MultiplyUsingMatrix(SoulTransform* OutTransform, const SoulTransform* A, const SoulTransform* B) {
     glm::mat4 ma = A->toMatrix();
     glm::mat4 mb = B->toMatrix();
     glm::mat4 mc = ma * mb;
     *OutTransform = SoulTransform(mc);
 }
 
+static void Multiply(SoulTransform* OutTransform, const SoulTransform* A, const SoulTransform* B) {
+    // B's scale is applied last, any positive one works
+    if (!HasUniformPositiveScale(A->scale) || B->scale.x < 0.f || B->scale.y < 0.f || B->scale.z < 0.f) {
+        MultiplyUsingMatrix(OutTransform, A, B);
+        return;
+    }
+
+    // write through temporaries, OutTransform may alias A or B
+    const glm::vec3 translation = A->translation + A->rotation * (A->scale * B->translation);
+    const glm::quat rotation = glm::normalize(A->rotation * B->rotation);
+    const glm::vec3 scale = A->scale * B->scale;
+
+    OutTransform->translation = translation;
+    OutTransform->rotation = rotation;
+    OutTransform->scale = scale;
+}
+
+static void Inverse(SoulTransform* OutTransform, const SoulTransform* A) {
+    // (T*R*S).inv = S.inv * R.inv * T.inv
+    const glm::quat invRotation = glm::conjugate(A->rotation);
+    const glm::vec3 invScale = GetSafeScaleReciprocal(A->scale);
+    const glm::vec3 invTranslation = invScale * (invRotation * (-A->translation));
+
+    OutTransform->translation = invTranslation;
+    OutTransform->rotation = invRotation;
+    OutTransform->scale = invScale;
+}
+
 void SoulTransform::LeftDivide(SoulTransform* OutTransform, const SoulTransform* A, const SoulTransform* B) const {
-    // TODO: avoid decompose
-    glm::mat4 ma = glm::inverse(A->toMatrix());
-    glm::mat4 mb = B->toMatrix();
-    glm::mat4 mc = ma * mb;
-    *OutTransform = SoulTransform(mc);
+    // A.inv * B
+    if (!HasUniformPositiveScale(A->scale) || B->scale.x < 0.f || B->scale.y < 0.f || B->scale.z < 0.f) {
+        glm::mat4 ma = glm::inverse(A->toMatrix());
+        glm::mat4 mb = B->toMatrix();
+        glm::mat4 mc = ma * mb;
+        *OutTransform = SoulTransform(mc);
+        return;
+    }
+
+    const glm::quat invRotation = glm::conjugate(A->rotation);
+    const glm::vec3 invScale = GetSafeScaleReciprocal(A->scale);
+
+    const glm::vec3 translation = invScale * (invRotation * (B->translation - A->translation));
+    const glm::quat rotation = glm::normalize(invRotation * B->rotation);
+    const glm::vec3 scale = invScale * B->scale;
+
+    OutTransform->translation = translation;
+    OutTransform->rotation = rotation;
+    OutTransform->scale = scale;
 }
 
 void SoulTransform::Divide(SoulTransform* OutTransform, const SoulTransform* A, const SoulTransform* B) const {
-    // TODO: avoid decompose
-    glm::mat4 ma = A->toMatrix();
-    glm::mat4 mb = B->toMatrix();
-    glm::mat4 mc = ma / mb;
-    *OutTransform = SoulTransform(mc);
+    // glm: A / B = A * B.inv, inverting B and multiplying by A both need uniform scale
+    if (!HasUniformPositiveScale(A->scale) || !HasUniformPositiveScale(B->scale)) {
+        glm::mat4 ma = A->toMatrix();
+        glm::mat4 mb = B->toMatrix();
+        glm::mat4 mc = ma / mb;
+        *OutTransform = SoulTransform(mc);
+        return;
+    }
+
+    SoulTransform invB;
+    ::Inverse(&invB, B);
+    Multiply(OutTransform, A, &invB);
 }
 
 SoulTransform SoulTransform::operator*(const SoulTransform& Other) const {
@@ -61,21 +131,22 @@ SoulTransform SoulTransform::operator/(const SoulTransform& Other) const {
 }
 
 SoulTransform SoulTransform::Inverse() {
-    glm::mat4 m = glm::inverse(toMatrix());
-    return SoulTransform(m);
+    SoulTransform Output;
+    if (!HasUniformPositiveScale(scale)) {
+        glm::mat4 m = glm::inverse(toMatrix());
+        return SoulTransform(m);
+    }
+    ::Inverse(&Output, this);
+    return Output;
 }
 
 glm::mat4 SoulTransform::toMatrix() const {
-    // TODO: directly calc element
-    glm::quat q(rotation.w, rotation.x, rotation.y, rotation.z);
-    glm::vec3 t(translation.x, translation.y, translation.z);
-    glm::vec3 s(scale.x, scale.y, scale.z);
-
-    glm::mat4 identity(1.0);
-    glm::mat4 mt = glm::translate(identity, t);
-    glm::mat4 ms = glm::scale(identity, s);
-    glm::mat4 mr = glm::mat4_cast(q);
-    glm::mat4 OutMatrix = mt * mr * ms;
+    // T * R * S, filled directly instead of multiplying three matrices
+    glm::mat4 OutMatrix = glm::mat4_cast(rotation);
+    OutMatrix[0] *= scale.x;
+    OutMatrix[1] *= scale.y;
+    OutMatrix[2] *= scale.z;
+    OutMatrix[3] = glm::vec4(translation, 1.0f);
     return OutMatrix;
 }
 
@@ -116,24 +187,53 @@ void SoulSkeletonMesh::calcNormal() {
     }
 }
 
-static std::shared_ptr<SoulNode> findNodeByName(std::string const& name, std::shared_ptr<SoulNode> const& node, int depth) {
-
-    if (node->name == name) {
-        return node;
-    } 
+void SoulScene::buildNodeIndex() {
+    const int32_t nodeCount = static_cast<int32_t>(nodes.size());
 
-    for(auto& child : node->children) {
-        auto ret = findNodeByName(name, child, depth+1);
-        if (ret != nullptr) {
-            return ret;
+    // children packed per parent, counting sort keeps them in node order (= child order)
+    std::vector<int32_t> fill(nodeCount + 1, 0);
+    for (int32_t i = 0; i < nodeCount; i++) {
+        assert(nodes[i].parentIndex < i);
+        if (nodes[i].parentIndex >= 0) {
+            fill[nodes[i].parentIndex + 1]++;
+        }
+    }
+    for (int32_t i = 0; i < nodeCount; i++) {
+        nodes[i].childBegin = fill[i];
+        nodes[i].childCount = fill[i + 1];
+        fill[i + 1] += fill[i];
+    }
+    nodeChildren.resize(nodeCount > 0 ? fill[nodeCount] : 0);
+    for (int32_t i = 0; i < nodeCount; i++) {
+        fill[i] = nodes[i].childBegin;
+    }
+    for (int32_t i = 0; i < nodeCount; i++) {
+        if (nodes[i].parentIndex >= 0) {
+            nodeChildren[fill[nodes[i].parentIndex]++] = i;
         }
     }
 
-    return nullptr;
+    // emplace keeps the first node of a name, the one a depth first search finds
+    nodeIndexByName.clear();
+    nodeIndexByName.reserve(nodeCount);
+    for (int32_t i = 0; i < nodeCount; i++) {
+        nodeIndexByName.emplace(nodes[i].name, i);
+    }
+}
+
+int32_t SoulScene::findNodeIndexByName(std::string const& name) const {
+    auto it = nodeIndexByName.find(name);
+    return it != nodeIndexByName.end() ? it->second : -1;
+}
+
+SoulNode* SoulScene::findNodeByName(std::string const& name) {
+    const int32_t index = findNodeIndexByName(name);
+    return index >= 0 ? &nodes[index] : nullptr;
 }
 
-std::shared_ptr<SoulNode> SoulScene::findNodeByName(std::string const& name) const {
-    return ::findNodeByName(name, rootNode, 0);
+SoulNode const* SoulScene::findNodeByName(std::string const& name) const {
+    const int32_t index = findNodeIndexByName(name);
+    return index >= 0 ? &nodes[index] : nullptr;
 }
 
 const SoulIK::SoulMetaData* SoulIK::SoulScene::getMetaByKey(const std::string& key) {
@@ -170,14 +170,25 @@ namespace SoulIK {
         void calcNormal();
     };
 
+    // [first, last) of a packed index array
+    struct SoulIndexRange {
+        const int32_t* first{nullptr};
+        const int32_t* last{nullptr};
+
+        const int32_t* begin() const { return first; }
+        const int32_t* end() const { return last; }
+        size_t size() const { return last - first; }
+        int32_t operator[](size_t i) const { return first[i]; }
+    };
+
     // node
     struct SoulNode {
         std::string name;
 
-        // tree
-        SoulNode* parent;
-        std::vector<std::shared_ptr<SoulNode>> children;
-        //uint32_t parentIndex;  // todo: rootNode tree or nodes array with parentIndex
+        // tree, indices into SoulScene::nodes, filled by SoulScene::buildNodeIndex() except parentIndex
+        int32_t parentIndex{-1};    // -1 for the root
+        int32_t childBegin{0};      // children are SoulScene::nodeChildren[childBegin, childBegin + childCount)
+        int32_t childCount{0};
         glm::mat4 transform; // transformation relative to parent, local
 
         // data
@@ -208,8 +219,10 @@ namespace SoulIK {
     struct SoulScene {
         std::string name;
 
-        // node tree
-        std::shared_ptr<SoulNode> rootNode; // todo: rootNode tree or nodes array with parentIndex
+        // node tree, flat in depth first order: nodes[0] is the root, every parent comes before its children
+        std::vector<SoulNode> nodes;
+        std::vector<int32_t> nodeChildren;                          // child ranges of all nodes, in child order
+        std::unordered_map<std::string, int32_t> nodeIndexByName;   // first node of each name
 
         // meshes
         std::vector<std::shared_ptr<SoulSkeletonMesh>> skmeshes;
@@ -226,7 +239,23 @@ namespace SoulIK {
 
 
         // member function
-        std::shared_ptr<SoulNode> findNodeByName(std::string const& name) const;
+
+        // child ranges and name index from SoulNode::parentIndex, call after building or editing nodes
+        void buildNodeIndex();
+
+        // tree view over nodes, for code walking it like a pointer tree
+        SoulNode* getRootNode() { return nodes.empty() ? nullptr : &nodes[0]; }
+        SoulNode* getParent(SoulNode const& node) { return node.parentIndex < 0 ? nullptr : &nodes[node.parentIndex]; }
+        SoulIndexRange getChildren(SoulNode const& node) const {
+            const int32_t* first = nodeChildren.data() + node.childBegin;
+            return SoulIndexRange{first, first + node.childCount};
+        }
+        int32_t getNodeIndex(SoulNode const& node) const { return static_cast<int32_t>(&node - nodes.data()); }
+
+        // -1 / nullptr if there is no node of that name
+        int32_t findNodeIndexByName(std::string const& name) const;
+        SoulNode* findNodeByName(std::string const& name);
+        SoulNode const* findNodeByName(std::string const& name) const;
         const SoulMetaData* getMetaByKey(const std::string& key);
         void removeMetaByKey(const std::string& key);
     };
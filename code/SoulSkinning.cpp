@@ -0,0 +1,110 @@
+//
+//  SoulSkinning.cpp
+//
+//  skinning matrix palette from global poses
+//
+
+#include "SoulSkinning.h"
+#include "SoulFTransformBatch.h"
+#include <cassert>
+
+using namespace SoulIK;
+
+namespace
+{
+    // G * InverseBind, G = translate(T) * rotate(R) * scale(S), packed to 3x4
+    inline void ComputeJointMatrix(
+        const FQuat& R, const FVector& T, const FVector& S,
+        const glm::mat4& InverseBind,
+        FMatrix3x4& Out)
+    {
+        // columns of G in float, same terms as FTransform::ToMatrixWithScale
+        const float x = float(R.x), y = float(R.y), z = float(R.z), w = float(R.w);
+        const float x2 = x + x, y2 = y + y, z2 = z + z;
+        const float xx2 = x * x2, yy2 = y * y2, zz2 = z * z2;
+        const float xy2 = x * y2, xz2 = x * z2, yz2 = y * z2;
+        const float wx2 = w * x2, wy2 = w * y2, wz2 = w * z2;
+        const float sx = float(S.x), sy = float(S.y), sz = float(S.z);
+
+#if defined(SOULIK_SIMD_AVX2) || defined(SOULIK_SIMD_SSE4)
+        const __m128 g0 = _mm_setr_ps((1.0f - (yy2 + zz2)) * sx, (xy2 + wz2) * sx, (xz2 - wy2) * sx, 0.0f);
+        const __m128 g1 = _mm_setr_ps((xy2 - wz2) * sy, (1.0f - (xx2 + zz2)) * sy, (yz2 + wx2) * sy, 0.0f);
+        const __m128 g2 = _mm_setr_ps((xz2 + wy2) * sz, (yz2 - wx2) * sz, (1.0f - (xx2 + yy2)) * sz, 0.0f);
+        const __m128 g3 = _mm_setr_ps(float(T.x), float(T.y), float(T.z), 1.0f);
+
+        // column j of G * B = G * B[j]
+        __m128 c[4];
+        for (int j = 0; j < 4; ++j)
+        {
+            const float* b = &InverseBind[j][0];
+            __m128 r = _mm_mul_ps(g0, _mm_set1_ps(b[0]));
+            r = _mm_add_ps(r, _mm_mul_ps(g1, _mm_set1_ps(b[1])));
+            r = _mm_add_ps(r, _mm_mul_ps(g2, _mm_set1_ps(b[2])));
+            r = _mm_add_ps(r, _mm_mul_ps(g3, _mm_set1_ps(b[3])));
+            c[j] = r;
+        }
+
+        // columns -> rows, the 4th row (0 0 0 1) is dropped
+        _MM_TRANSPOSE4_PS(c[0], c[1], c[2], c[3]);
+        _mm_storeu_ps(Out.M[0], c[0]);
+        _mm_storeu_ps(Out.M[1], c[1]);
+        _mm_storeu_ps(Out.M[2], c[2]);
+#else
+        glm::mat4 G(1.0f);
+        G[0] = glm::vec4((1.0f - (yy2 + zz2)) * sx, (xy2 + wz2) * sx, (xz2 - wy2) * sx, 0.0f);
+        G[1] = glm::vec4((xy2 - wz2) * sy, (1.0f - (xx2 + zz2)) * sy, (yz2 + wx2) * sy, 0.0f);
+        G[2] = glm::vec4((xz2 + wy2) * sz, (yz2 - wx2) * sz, (1.0f - (xx2 + yy2)) * sz, 0.0f);
+        G[3] = glm::vec4(float(T.x), float(T.y), float(T.z), 1.0f);
+
+        const glm::mat4 J = G * InverseBind;
+        for (int Row = 0; Row < 3; ++Row)
+        {
+            for (int Col = 0; Col < 4; ++Col)
+            {
+                Out.M[Row][Col] = J[Col][Row];
+            }
+        }
+#endif
+    }
+}
+
+namespace SoulIK
+{
+    void ComputeSkinningPalette(const TArray<FTransform>& GlobalPose, const SoulSkeleton& Skeleton, TArray<FMatrix3x4>& OutPalette)
+    {
+        assert(GlobalPose.size() == Skeleton.joints.size());
+        OutPalette.resize(GlobalPose.size());
+        ComputeSkinningPalette(GlobalPose.data(), 1, Skeleton, OutPalette.data());
+    }
+
+    void ComputeSkinningPalette(const FPoseSoA& GlobalPose, const SoulSkeleton& Skeleton, TArray<FMatrix3x4>& OutPalette)
+    {
+        assert(GlobalPose.Num() == Skeleton.joints.size());
+        OutPalette.resize(GlobalPose.Num());
+        for (int32 JointIndex = 0; JointIndex < GlobalPose.Num(); ++JointIndex)
+        {
+            ComputeJointMatrix(
+                GlobalPose.Rotations[JointIndex], GlobalPose.Translations[JointIndex], GlobalPose.Scales[JointIndex],
+                Skeleton.joints[JointIndex].inverseBindposeMatrix,
+                OutPalette[JointIndex]);
+        }
+    }
+
+    void ComputeSkinningPalette(const FTransform* GlobalPoses, int32 NumFrames, const SoulSkeleton& Skeleton, FMatrix3x4* OutPalette)
+    {
+        const int32 NumJoints = (int32)Skeleton.joints.size();
+        for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+        {
+            const FTransform* Pose = GlobalPoses + Frame * NumJoints;
+            FMatrix3x4* Palette = OutPalette + Frame * NumJoints;
+            for (int32 JointIndex = 0; JointIndex < NumJoints; ++JointIndex)
+            {
+                const FTransform& Global = Pose[JointIndex];
+                ComputeJointMatrix(
+                    Global.Rotation, Global.Translation, Global.Scale3D,
+                    Skeleton.joints[JointIndex].inverseBindposeMatrix,
+                    Palette[JointIndex]);
+            }
+        }
+    }
+}
@@ -0,0 +1,31 @@
+//
+//  SoulSkinning.h
+//
+//  skinning matrix palette from global poses
+//
+
+#pragma once
+
+#include "SoulScene.hpp"
+#include "SoulPoseSoA.h"
+
+namespace SoulIK
+{
+    // affine joint matrix packed as 3 rows of 4 floats, column vector convention:
+    //   p' = (dot(Row[0], p), dot(Row[1], p), dot(Row[2], p)),  p = (x, y, z, 1)
+    // upload as 3 vec4 per joint
+    struct FMatrix3x4
+    {
+        float M[3][4];
+    };
+
+    // jointMatrix(j) = globalTransformOfJointNode(j) * inverseBindPoseMatrixForJoint(j)  (see README)
+    // GlobalPose is indexed like Skeleton.joints and must be in the space the bind pose was authored in
+    // (ie. after converting a retargeted pose back to the target coord)
+    void ComputeSkinningPalette(const TArray<FTransform>& GlobalPose, const SoulSkeleton& Skeleton, TArray<FMatrix3x4>& OutPalette);
+    void ComputeSkinningPalette(const FPoseSoA& GlobalPose, const SoulSkeleton& Skeleton, TArray<FMatrix3x4>& OutPalette);
+
+    // batch of frames: GlobalPoses holds NumFrames poses of Skeleton.joints.size() transforms back to back,
+    // OutPalette receives NumFrames * Skeleton.joints.size() matrices in the same order
+    void ComputeSkinningPalette(const FTransform* GlobalPoses, int32 NumFrames, const SoulSkeleton& Skeleton, FMatrix3x4* OutPalette);
+}
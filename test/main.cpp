@@ -6,11 +6,19 @@
 //
 
 #include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
 
 #include "SoulScene.hpp"
 #include "SoulRetargeter.h"
 #include "IKRigUtils.hpp"
 #include "SoulIKRetargetProcessor.h"
+#include "SoulFTransformBatch.h"
 
 #include "FBXRW.h"
 #include "ObjRW.h"
@@ -642,8 +650,430 @@ static void getFilePaths(std::string& srcAnimationFile,
     outfile             = modelPath + testcase.outFile;
 }
 
+/////////////////////////////////////////////
+// checks, run as "testikrigretarget <check>", each returns false on failure
+
+// the matrix + decompose path SoulTransform used before the closed form, kept as reference
+static glm::mat4 soulTransformToMatrixRef(SoulTransform const& t) {
+    glm::mat4 identity(1.0);
+    return glm::translate(identity, t.translation) * glm::mat4_cast(t.rotation) * glm::scale(identity, t.scale);
+}
+
+static SoulTransform soulMultiplyRef(SoulTransform const& a, SoulTransform const& b) {
+    return SoulTransform(soulTransformToMatrixRef(a) * soulTransformToMatrixRef(b));
+}
+
+static SoulTransform soulLeftDivideRef(SoulTransform const& a, SoulTransform const& b) {
+    return SoulTransform(glm::inverse(soulTransformToMatrixRef(a)) * soulTransformToMatrixRef(b));
+}
+
+static SoulTransform soulDivideRef(SoulTransform const& a, SoulTransform const& b) {
+    return SoulTransform(soulTransformToMatrixRef(a) / soulTransformToMatrixRef(b));
+}
+
+static SoulTransform soulInverseRef(SoulTransform const& a) {
+    return SoulTransform(glm::inverse(soulTransformToMatrixRef(a)));
+}
+
+struct SoulTransformError {
+    float translation = 0.f;    // relative to the translation length, at least 1
+    float rotation = 0.f;       // per component, sign aligned
+    float scale = 0.f;          // relative
+};
+
+static void accumulateError(SoulTransformError& err, SoulTransform const& t, SoulTransform const& ref) {
+    err.translation = std::max(err.translation, glm::length(t.translation - ref.translation) / std::max(1.f, glm::length(ref.translation)));
+    const float sign = glm::dot(t.rotation, ref.rotation) < 0.f ? -1.f : 1.f;
+    for (int i = 0; i < 4; i++) {
+        err.rotation = std::max(err.rotation, std::abs(sign * t.rotation[i] - ref.rotation[i]));
+    }
+    for (int i = 0; i < 3; i++) {
+        err.scale = std::max(err.scale, std::abs(t.scale[i] - ref.scale[i]) / std::abs(ref.scale[i]));
+    }
+}
+
+static std::vector<SoulTransform> randomSoulTransforms(size_t count, bool uniformScale, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+    std::uniform_real_distribution<float> scale(0.5f, 2.f);
+    std::vector<SoulTransform> transforms(count);
+    for (auto& t : transforms) {
+        t.translation = glm::vec3(unit(rng), unit(rng), unit(rng)) * 100.f;
+        t.rotation = glm::normalize(glm::quat(unit(rng), unit(rng), unit(rng), unit(rng)));
+        const float s = scale(rng);
+        t.scale = uniformScale ? glm::vec3(s) : glm::vec3(s, scale(rng), scale(rng));
+    }
+    return transforms;
+}
+
+// closed form SoulTransform ops against the matrix + decompose path: agreement and time per op
+// the closed form is only exact for uniform parent scale (see SoulScene.cpp), non-uniform scale takes the matrix path
+// and must give the old matrix result
+static bool checkSoulTransform() {
+    const size_t count = 200000;
+    struct Inputs {
+        const char* name;
+        std::vector<SoulTransform> as;
+        std::vector<SoulTransform> bs;
+    };
+    const Inputs inputs[] = {
+        {"uniform", randomSoulTransforms(count, true, 1), randomSoulTransforms(count, true, 2)},
+        {"non-uniform", randomSoulTransforms(count, false, 3), randomSoulTransforms(count, false, 4)},
+    };
+    std::vector<SoulTransform> out(count), ref(count);
+
+    struct Op {
+        const char* name;
+        SoulTransform (*closedForm)(SoulTransform const&, SoulTransform const&);
+        SoulTransform (*reference)(SoulTransform const&, SoulTransform const&);
+    };
+    const Op ops[] = {
+        {"multiply", [](SoulTransform const& a, SoulTransform const& b) { return a * b; }, soulMultiplyRef},
+        {"leftdivide", [](SoulTransform const& a, SoulTransform const& b) { return b.GetRelativeTransform(a); }, soulLeftDivideRef},
+        {"divide", [](SoulTransform const& a, SoulTransform const& b) { return a / b; }, soulDivideRef},
+        {"inverse", [](SoulTransform const& a, SoulTransform const&) { SoulTransform t = a; return t.Inverse(); },
+            [](SoulTransform const& a, SoulTransform const&) { return soulInverseRef(a); }},
+    };
+
+    // float math through a 4x4 matrix and back, a few times what the random cases reach
+    const SoulTransformError bound = {5e-5f, 3e-6f, 1e-5f};
+    bool ok = true;
+    for (const Inputs& in : inputs) {
+        for (const Op& op : ops) {
+            auto t0 = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < count; i++) {
+                out[i] = op.closedForm(in.as[i], in.bs[i]);
+            }
+            auto t1 = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < count; i++) {
+                ref[i] = op.reference(in.as[i], in.bs[i]);
+            }
+            auto t2 = std::chrono::steady_clock::now();
+
+            SoulTransformError err;
+            for (size_t i = 0; i < count; i++) {
+                accumulateError(err, out[i], ref[i]);
+            }
+            const double closedNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / count;
+            const double refNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / count;
+            const bool opOk = err.translation <= bound.translation && err.rotation <= bound.rotation && err.scale <= bound.scale;
+            printf("soultransform %-11s %-10s %6.1f ns (matrix %6.1f ns, %4.1fx)  err t %.2e r %.2e s %.2e %s\n",
+                in.name, op.name, closedNs, refNs, refNs / closedNs, err.translation, err.rotation, err.scale, opOk ? "ok" : "FAILED");
+            ok = ok && opOk;
+        }
+    }
+    return ok;
+}
+
+template<typename T>
+static void accumulateQuatError(T& normError, T& refError, const TQuat<T>& q, const TQuat<T>& ref) {
+    normError = std::max(normError, std::abs(std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w) - T(1)));
+    refError = std::max({refError, std::abs(q.x - ref.x), std::abs(q.y - ref.y), std::abs(q.z - ref.z), std::abs(q.w - ref.w)});
+}
+
+// TransformKernel::Normalize / NLerp (and NormalizeN / NLerpN for FReal) against GetNormalized / FastLerp
+// over random quaternions of length 0.25 to 4, both | |q| - 1 | and the distance to the reference stay within Bound
+template<typename T>
+static bool checkQuatKernelsOf(const char* typeName, T bound) {
+    const int32 count = 1000000;
+    const int32 alphaRun = 1000;    // NLerpN takes one alpha per call
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<T> unit(-1, 1);
+    std::uniform_real_distribution<T> logLength(std::log(T(0.25)), std::log(T(4)));
+    std::uniform_real_distribution<T> alphaDist(0, 1);
+    auto randomQuat = [&]() {
+        TQuat<T> q(unit(rng), unit(rng), unit(rng), unit(rng));
+        const T scale = std::exp(logLength(rng)) / std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+        return TQuat<T>(q.x * scale, q.y * scale, q.z * scale, q.w * scale);
+    };
+    std::vector<TQuat<T>> as(count), bs(count), out(count);
+    std::vector<T> alphas(count / alphaRun);
+    for (int32 i = 0; i < count; i++) {
+        as[i] = randomQuat();
+        bs[i] = randomQuat();
+    }
+    for (T& alpha : alphas) {
+        alpha = alphaDist(rng);
+    }
+    // below UE_SMALL_NUMBER both sides return identity
+    as[0] = TQuat<T>(T(1e-5), 0, 0, 0);
+
+    T normError = 0, refError = 0;
+    for (int32 i = 0; i < count; i++) {
+        TransformKernel::Normalize(out[i], as[i]);
+        accumulateQuatError(normError, refError, out[i], as[i].GetNormalized());
+    }
+    bool ok = normError <= bound && refError <= bound;
+    printf("quat %-6s Normalize   |q|-1 %.2e  ref %.2e\n", typeName, normError, refError);
+
+    normError = refError = 0;
+    for (int32 i = 0; i < count; i++) {
+        const T alpha = alphas[i / alphaRun];
+        TransformKernel::NLerp(out[i], as[i], bs[i], alpha);
+        accumulateQuatError(normError, refError, out[i], TQuat<T>::FastLerp(as[i], bs[i], alpha).GetNormalized());
+    }
+    ok = ok && normError <= bound && refError <= bound;
+    printf("quat %-6s NLerp       |q|-1 %.2e  ref %.2e\n", typeName, normError, refError);
+
+    if constexpr (std::is_same<T, FReal>::value) {
+        normError = refError = 0;
+        NormalizeN(out.data(), as.data(), count);
+        for (int32 i = 0; i < count; i++) {
+            accumulateQuatError(normError, refError, out[i], as[i].GetNormalized());
+        }
+        ok = ok && normError <= bound && refError <= bound;
+        printf("quat %-6s NormalizeN  |q|-1 %.2e  ref %.2e\n", typeName, normError, refError);
+
+        normError = refError = 0;
+        for (int32 run = 0; run < count; run += alphaRun) {
+            NLerpN(out.data() + run, as.data() + run, bs.data() + run, alphas[run / alphaRun], alphaRun);
+        }
+        for (int32 i = 0; i < count; i++) {
+            const T alpha = alphas[i / alphaRun];
+            accumulateQuatError(normError, refError, out[i], TQuat<T>::FastLerp(as[i], bs[i], alpha).GetNormalized());
+        }
+        ok = ok && normError <= bound && refError <= bound;
+        printf("quat %-6s NLerpN      |q|-1 %.2e  ref %.2e\n", typeName, normError, refError);
+    }
+    return ok;
+}
+
+// documented bounds of the quaternion kernels (SoulFTransformBatch.h), for the simd path of this build
+static bool checkQuatKernels() {
+#if defined(SOULIK_SIMD_AVX2)
+    printf("quat kernels: AVX2\n");
+#elif defined(SOULIK_SIMD_SSE4)
+    printf("quat kernels: SSE4\n");
+#else
+    printf("quat kernels: scalar\n");
+#endif
+    const bool doubleOk = checkQuatKernelsOf<double>("double", 1e-13);
+    const bool floatOk = checkQuatKernelsOf<float>("float", 3e-7f);
+    return doubleOk && floatOk;
+}
+
+// the template statics of SoulFTransform.h / SoulDualQuat.h are initialized in no set order,
+// a constant built from another one that is not set yet stays zero for the whole run
+template<typename T>
+static bool checkIdentityOf(const char* typeName) {
+    const TTransform<T>& t = TTransform<T>::Identity;
+    const TDualQuat<T>& dq = TDualQuat<T>::Identity;
+    const bool vectorOk = TVector<T>::OneVector == TVector<T>(1, 1, 1) && TVector<T>::ZeroVector == TVector<T>(0, 0, 0);
+    const bool quatOk = TQuat<T>::Identity.w == T(1) && TQuat<T>::Identity.x == T(0) && TQuat<T>::Identity.y == T(0) && TQuat<T>::Identity.z == T(0);
+    const bool transformOk = t.Rotation.w == T(1) && t.Rotation.x == T(0) && t.Rotation.y == T(0) && t.Rotation.z == T(0) &&
+        t.Translation == TVector<T>(0, 0, 0) && t.Scale3D == TVector<T>(1, 1, 1);
+    const bool dualQuatOk = dq.Real.w == T(1) && dq.Real.x == T(0) && dq.Real.y == T(0) && dq.Real.z == T(0) &&
+        dq.Dual.w == T(0) && dq.Dual.x == T(0) && dq.Dual.y == T(0) && dq.Dual.z == T(0);
+    printf("identity %-6s vector %s quat %s transform scale (%g %g %g) %s dualquat real.w %g %s\n", typeName,
+        vectorOk ? "ok" : "FAILED", quatOk ? "ok" : "FAILED",
+        (double)t.Scale3D.x, (double)t.Scale3D.y, (double)t.Scale3D.z, transformOk ? "ok" : "FAILED",
+        (double)dq.Real.w, dualQuatOk ? "ok" : "FAILED");
+    return vectorOk && quatOk && transformOk && dualQuatOk;
+}
+
+static bool checkIdentity() {
+    const bool doubleOk = checkIdentityOf<double>("double");
+    const bool floatOk = checkIdentityOf<float>("float");
+    return doubleOk && floatOk;
+}
+
+// every heap allocation of the process, counted for the allocs check
+static std::atomic<size_t> allocationCount{0};
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    void* p = nullptr;
+#ifdef _WIN32
+    p = _aligned_malloc(size ? size : 1, static_cast<size_t>(align));
+#else
+    if (posix_memalign(&p, std::max(static_cast<size_t>(align), sizeof(void*)), size ? size : 1) != 0) {
+        p = nullptr;
+    }
+#endif
+    if (p) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+void* operator new[](std::size_t size, std::align_val_t align) { return operator new(size, align); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+#ifdef _WIN32
+void operator delete(void* p, std::align_val_t) noexcept { _aligned_free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { _aligned_free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { _aligned_free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { _aligned_free(p); }
+#else
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+#endif
+
+// the first run sizes the context, every later one must run without touching the heap:
+// FK, dual quaternion, masked, batch, level parallel and parallel FK chain runs of case_Flair2
+static bool checkAllocations() {
+    TestCase testCase = case_Flair2();
+    SoulIKRigRetargetConfig& config = testCase.config;
+    std::string srcAnimationFile, srcTPoseFile, targetFile, targetTPoseFile, outfile;
+    getFilePaths(srcAnimationFile, srcTPoseFile, targetFile, targetTPoseFile, outfile, testCase);
+
+    // only the skeletons are needed, the target TPose file has the same one as the target
+    SoulIK::FBXRW fbxSrcAnimation, fbxSrcTPose, fbxTarget;
+    fbxSrcAnimation.readPureSkeletonWithDefualtMesh(srcAnimationFile, config.SourceRootBone);
+    fbxSrcTPose.readPureSkeletonWithDefualtMesh(srcTPoseFile, config.SourceRootBone);
+    fbxTarget.readSkeletonMesh(targetTPoseFile);
+    SoulScene& srcscene = *fbxSrcAnimation.getSoulScene();
+    SoulScene& srcTPoseScene = *fbxSrcTPose.getSoulScene();
+    SoulScene& tgtscene = *fbxTarget.getSoulScene();
+    if (srcscene.skmeshes.empty() || srcTPoseScene.skmeshes.empty() || tgtscene.skmeshes.empty()) {
+        printf("allocs: model files missing\n");
+        return false;
+    }
+    SoulSkeletonMesh& srcskm = *srcscene.skmeshes[0];
+    SoulSkeletonMesh& tgtskm = *tgtscene.skmeshes[0];
+
+    USkeleton srcusk, tgtusk;
+    IKRigUtils::getUSkeletonFromMesh(srcTPoseScene, *srcTPoseScene.skmeshes[0], srcusk, config.SourceCoord, config.WorkCoord);
+    IKRigUtils::getUSkeletonFromMesh(tgtscene, tgtskm, tgtusk, config.TargetCoord, config.WorkCoord);
+    if (!IKRigUtils::alignUSKWithSkeleton(srcusk, srcskm.skeleton, srcTPoseScene, srcscene) ||
+        !IKRigUtils::alignUSKWithSkeleton(tgtusk, tgtskm.skeleton, tgtscene, tgtscene)) {
+        return false;
+    }
+
+    // source frames: the TPose with every bone turned a little more each frame
+    const int frameCount = 16;
+    const size_t srcJointCount = srcskm.skeleton.joints.size();
+    const size_t tgtJointCount = tgtskm.skeleton.joints.size();
+    std::vector<FTransform> inposes(frameCount * srcJointCount);
+    for (int frame = 0; frame < frameCount; frame++) {
+        std::vector<FTransform> local = srcusk.refpose;
+        std::vector<FTransform> global(srcJointCount);
+        for (size_t i = 0; i < srcJointCount; i++) {
+            local[i].Rotation = local[i].Rotation * FRotator(2.0 * frame, 3.0 * frame, 1.0 * frame).Quaternion();
+        }
+        local[0].Translation.x += frame;
+        IKRigUtils::FPoseToGlobal(srcskm.skeleton, local, global);
+        std::copy(global.begin(), global.end(), inposes.begin() + frame * srcJointCount);
+    }
+
+    enum class ERun { Full, Masked, Batch };
+    struct Run {
+        const char* name;
+        ERun type;
+        void (*setup)(FRetargetGlobalSettings&);
+    };
+    const Run runs[] = {
+        {"fk", ERun::Full, [](FRetargetGlobalSettings&) {}},
+        {"dual quat", ERun::Full, [](FRetargetGlobalSettings& s) { s.bDualQuatPoses = true; }},
+        {"masked", ERun::Masked, [](FRetargetGlobalSettings&) {}},
+        {"batch", ERun::Batch, [](FRetargetGlobalSettings&) {}},
+        {"level parallel", ERun::Full, [](FRetargetGlobalSettings& s) { s.bLevelHierarchyUpdates = true; s.ParallelLevelMinBones = 1; }},
+        {"parallel fk chains", ERun::Full, [](FRetargetGlobalSettings& s) { s.bParallelFKChains = true; }},
+    };
+
+    // worker threads even on a single core machine, so the parallel runs leave the calling thread
+    const int32 workerCount = GetParallelWorkerCount();
+    SetParallelWorkerCount(3);
+
+    std::unordered_map<FName, float> SpeedValuesFromCurves;
+    const float DeltaTime = 1.0f / 30.0f;
+    const int batchSize = 4;
+    bool ok = true;
+    for (const Run& run : runs) {
+        auto asset = IKRigUtils::createIKRigAsset(config, srcskm.skeleton, tgtskm.skeleton, srcusk, tgtusk);
+        run.setup(asset->GlobalSettings->Settings);
+        UIKRetargetProcessor ikretarget;
+        ikretarget.Initialize(&srcusk, &tgtusk, asset.get(), true);
+        if (!ikretarget.GetPlan()->bIsInitialized) {
+            printf("allocs %-18s plan not initialized\n", run.name);
+            ok = false;
+            continue;
+        }
+        if (asset->GlobalSettings->Settings.bDualQuatPoses && !ikretarget.GetPlan()->bDualQuatPoses) {
+            printf("allocs %-18s retarget pose has scale, runs FTransform math\n", run.name);
+        }
+        FRetargetBoneMask mask;
+        if (run.type == ERun::Masked && !ikretarget.InitializeBoneMask({FName("spine"), FName("head")}, {}, mask)) {
+            printf("allocs %-18s mask not initialized\n", run.name);
+            ok = false;
+            continue;
+        }
+
+        std::vector<FTransform> inpose(srcJointCount);
+        std::vector<FTransform> outpose;
+        std::vector<FTransform> outposes(batchSize * tgtJointCount);
+        const int step = run.type == ERun::Batch ? batchSize : 1;
+        size_t firstAllocations = 0;
+        size_t laterAllocations = 0;
+        for (int frame = 0; frame < frameCount; frame += step) {
+            std::copy(inposes.begin() + frame * srcJointCount, inposes.begin() + (frame + 1) * srcJointCount, inpose.begin());
+            const size_t before = allocationCount.load();
+            switch (run.type) {
+            case ERun::Full:
+                ikretarget.RunRetargeter(inpose, outpose, SpeedValuesFromCurves, DeltaTime, frame > 0);
+                break;
+            case ERun::Masked:
+                ikretarget.RunRetargeter(mask, inpose, outpose, SpeedValuesFromCurves, DeltaTime);
+                break;
+            case ERun::Batch:
+                ikretarget.RunRetargeterBatch(inposes.data() + frame * srcJointCount, batchSize, outposes.data(), SpeedValuesFromCurves, DeltaTime);
+                break;
+            }
+            const size_t allocations = allocationCount.load() - before;
+            (frame == 0 ? firstAllocations : laterAllocations) += allocations;
+        }
+        const bool runOk = laterAllocations == 0;
+        printf("allocs %-18s first run %4zu, later %d runs %zu %s\n",
+            run.name, firstAllocations, frameCount / step - 1, laterAllocations, runOk ? "ok" : "FAILED");
+        ok = ok && runOk;
+    }
+    SetParallelWorkerCount(workerCount);
+    return ok;
+}
+
+struct Check {
+    const char* name;
+    bool (*run)();
+};
+
+static const Check checks[] = {
+    {"soultransform", checkSoulTransform},
+    {"quat", checkQuatKernels},
+    {"allocs", checkAllocations},
+    {"identity", checkIdentity},
+};
+
 int main(int argc, char *argv[]) {
 
+    if (argc > 1) {
+        for (const Check& check : checks) {
+            if (strcmp(argv[1], check.name) == 0) {
+                const bool ok = check.run();
+                printf("%s: %s\n", check.name, ok ? "passed" : "FAILED");
+                return ok ? 0 : 1;
+            }
+        }
+        printf("unknown check %s, one of:", argv[1]);
+        for (const Check& check : checks) {
+            printf(" %s", check.name);
+        }
+        printf("\n");
+        return 1;
+    }
+
     /////////////////////////////////////////////
     // setting of coord
     TestCase testCase       = case_Flair2(); 
@@ -24,7 +24,7 @@ public:
     bool hasAnimation(){return m_hasAnimation; }
 
     void processNode(aiNode* node, const aiScene* scene, SoulScene& fbxScene,
-        SoulNode* parentSoulNode,
+        int32_t parentNodeIndex,
         std::vector<std::string>& materialNames, 
         std::vector<aiNode*>& nodes, std::vector<std::string>& nodeNames, std::vector<std::shared_ptr<SoulSkeletonMesh>>& skeletonMeshes);
 
@@ -48,7 +48,7 @@ public:
     void createDefaultMaterial(aiScene* scene);
     void createNodes(aiScene* scene, SoulScene& fbxScene);
     void createMesh(SoulSkeletonMesh& fbxMesh, aiMesh* mesh, aiScene* scene);
-    void createNode(SoulNode* node, aiNode* parentNode, aiScene* scene, int32_t nodeIndex);
+    void createNode(SoulScene& fbxScene, SoulNode const& node, aiNode* parentNode, aiScene* scene, int32_t nodeIndex);
     void createSkeleton(SoulSkeletonMesh &fbxMesh, aiMesh* mesh);
     void createSkeletonAnimation(std::vector<std::shared_ptr<SoulSkeletonMesh>>& skeletonMeshes, aiScene* scene);
 
@@ -252,7 +252,10 @@ void FBXRW::readSkeletonMesh(std::string inPath, float scale) {
     pimpl->processMetaData(m_soulScene->metaData, scene->mMetaData);
     
     // process mesh nodes
-    pimpl->processNode(scene->mRootNode, scene, *m_soulScene, nullptr, materialNames, nodes, nodeNames, m_soulScene->skmeshes);
+    m_soulScene->nodes.clear();
+    m_soulScene->nodes.reserve(nodes.size());
+    pimpl->processNode(scene->mRootNode, scene, *m_soulScene, -1, materialNames, nodes, nodeNames, m_soulScene->skmeshes);
+    m_soulScene->buildNodeIndex();
 
 
     // for (auto& name : nodeNames) {
@@ -262,22 +265,20 @@ void FBXRW::readSkeletonMesh(std::string inPath, float scale) {
 }
 
 void FBXRWImpl::processNode(aiNode *node, const aiScene* scene,  SoulScene& fbxScene,
-                        SoulNode* parentSoulNode,
+                        int32_t parentNodeIndex,
                         std::vector<std::string>& materialNames, 
                         std::vector<aiNode*>& nodes, 
                         std::vector<std::string>& nodeNames, 
                         std::vector<std::shared_ptr<SoulSkeletonMesh>>& skeletonMeshes) {
 
-    auto curNode = std::make_shared<SoulNode>();
+    // depth first, so the parent is already in the array, child ranges are built once at the end
+    const int32_t curNodeIndex = static_cast<int32_t>(fbxScene.nodes.size());
+    fbxScene.nodes.emplace_back();
+    SoulNode* curNode = &fbxScene.nodes.back();
     curNode->name = node->mName.data;
 
     // node tree and transform
-    curNode->parent = parentSoulNode;
-    if (parentSoulNode == nullptr) {
-        fbxScene.rootNode = curNode;
-    } else {
-        parentSoulNode->children.push_back(curNode);
-    }
+    curNode->parentIndex = parentNodeIndex;
     const auto& mat = node->mTransformation;
     // assimp row major, glm column major
     curNode->transform = glm::transpose(glm::mat4(
@@ -309,7 +310,7 @@ void FBXRWImpl::processNode(aiNode *node, const aiScene* scene,  SoulScene& fbxS
     
     // child nodes
     for(unsigned int i = 0; i < node->mNumChildren; i++) {
-        processNode(node->mChildren[i], scene, fbxScene, curNode.get(), materialNames, nodes, nodeNames, skeletonMeshes);
+        processNode(node->mChildren[i], scene, fbxScene, curNodeIndex, materialNames, nodes, nodeNames, skeletonMeshes);
     }
 }
 
@@ -685,7 +686,7 @@ void FBXRWImpl::processSkeletonAnimation(const aiScene* scene, SoulSkeletonMesh
     }
 }
 
-static void processJointNode(SoulSkeleton& sk, SoulNode* node, SoulTransform const& ParentGlobalTransform, int depth) {
+static void processJointNode(SoulScene& scene, SoulSkeleton& sk, SoulNode* node, SoulTransform const& ParentGlobalTransform, int32_t parentJointId, int depth) {
     if (node != nullptr) {
 
         SoulJoint joint;
@@ -699,16 +700,15 @@ static void processJointNode(SoulSkeleton& sk, SoulNode* node, SoulTransform con
         joint.inverseBindposeMatrix = glm::inverse(global.toMatrix());
 
         // parent
-        joint.parentId = -1;
-        if (node->parent != nullptr) {
-            joint.parentId = sk.getJointIdByName(node->parent->name);
-        }
+        // parent, -1 for the joint root
+        joint.parentId = parentJointId;
+        const int32_t jointId = static_cast<int32_t>(sk.joints.size());
 
         sk.joints.push_back(joint);
 
         // child
-        for (auto& child:  node->children) {
-            processJointNode(sk, child.get(), global, depth + 1);
+        for (int32_t child : scene.getChildren(*node)) {
+            processJointNode(scene, sk, &scene.nodes[child], global, jointId, depth + 1);
         }
     }
 }
@@ -755,8 +755,8 @@ bool FBXRWImpl::generateMeshFromPureSkeleton(SoulScene& soulScene, std::string c
 
     // skeleton
     mesh.skeleton;
-    SoulNode* jointRoot = soulScene.findNodeByName(rootBoneName).get();
-    processJointNode(mesh.skeleton, jointRoot, SoulTransform::identity, 0);
+    SoulNode* jointRoot = soulScene.findNodeByName(rootBoneName);
+    processJointNode(soulScene, mesh.skeleton, jointRoot, SoulTransform::identity, -1, 0);
 
     // skeleton animation
     processSkeletonAnimation(aiscene, mesh);
@@ -912,13 +912,14 @@ void FBXRWImpl::createDefaultMaterial(aiScene* scene) {
 }
 
 void FBXRWImpl::createNodes(aiScene* scene, SoulScene& fbxScene) {
-    createNode(fbxScene.rootNode.get(), nullptr, scene, 0);
+    createNode(fbxScene, *fbxScene.getRootNode(), nullptr, scene, 0);
 }
 
-void FBXRWImpl::createNode(SoulNode* node, aiNode* parentAINode, aiScene* scene, int32_t nodeIndex) {
+void FBXRWImpl::createNode(SoulScene& fbxScene, SoulNode const& node, aiNode* parentAINode, aiScene* scene, int32_t nodeIndex) {
     
+    SoulIndexRange children = fbxScene.getChildren(node);
     aiNode* curAINode = new aiNode;
-    curAINode->mName = node->name;
+    curAINode->mName = node.name;
 
     // tree
     curAINode->mParent = parentAINode;
@@ -927,12 +928,12 @@ void FBXRWImpl::createNode(SoulNode* node, aiNode* parentAINode, aiScene* scene,
     } else {
         parentAINode->mChildren[nodeIndex] = curAINode;
     }
-    curAINode->mNumChildren = (uint32_t)node->children.size();
+    curAINode->mNumChildren = (uint32_t)children.size();
     curAINode->mChildren = new aiNode* [curAINode->mNumChildren];
 
     // transform
     aiMatrix4x4& mat = curAINode->mTransformation;
-    auto& m = node->transform;
+    auto& m = node.transform;
     // assimp row major, glm column major
     mat = aiMatrix4x4(m[0][0], m[1][0], m[2][0], m[3][0],
                       m[0][1], m[1][1], m[2][1], m[3][1],
@@ -940,15 +941,15 @@ void FBXRWImpl::createNode(SoulNode* node, aiNode* parentAINode, aiScene* scene,
                       m[0][3], m[1][3], m[2][3], m[3][3]);
     
     // meshes
-    curAINode->mNumMeshes = (uint32_t)node->meshes.size();
+    curAINode->mNumMeshes = (uint32_t)node.meshes.size();
     curAINode->mMeshes = new unsigned int[curAINode->mNumMeshes];
     for(uint32_t i = 0; i < curAINode->mNumMeshes; i++) {
-        curAINode->mMeshes[i] = node->meshes[i];
+        curAINode->mMeshes[i] = node.meshes[i];
     }
 
     // recursive child node
-    for(int i = 0; i < node->children.size(); i++) {
-        createNode(node->children[i].get(), curAINode, scene, i);
+    for(int i = 0; i < children.size(); i++) {
+        createNode(fbxScene, fbxScene.nodes[children[i]], curAINode, scene, i);
     }
 }
 
@@ -191,22 +191,22 @@ static void copyToJointTransform(SoulScene const& scene) {
     }
 }
 
-static void applyNodeTransform(SoulNode* node) {
-    if (node->parent != nullptr) {
-        node->debugTransformGlobal = node->parent->debugTransformGlobal * node->transform;
-    } else {
-        node->debugTransformGlobal = node->transform;
-    }
-    for(auto& child: node->children) {
-        applyNodeTransform(child.get());
+static void applyNodeTransform(SoulScene& scene) {
+    // nodes are stored parents first
+    for(auto& node: scene.nodes) {
+        if (node.parentIndex >= 0) {
+            node.debugTransformGlobal = scene.nodes[node.parentIndex].debugTransformGlobal * node.transform;
+        } else {
+            node.debugTransformGlobal = node.transform;
+        }
     }
 }
 
-static void replacePose(SoulScene const& scene, SoulSkeleton& sk, SoulPose const& tpose) {
+static void replacePose(SoulScene& scene, SoulSkeleton& sk, SoulPose const& tpose) {
     assert(tpose.transforms.size() == sk.joints.size());
     for(size_t i = 0; i < sk.joints.size(); i++) {
         std::string name = sk.joints[i].name;
-        SoulNode* node = scene.findNodeByName(name).get();
+        SoulNode* node = scene.findNodeByName(name);
         
         assert(node != nullptr);
         if (node != nullptr) {
@@ -215,15 +215,15 @@ static void replacePose(SoulScene const& scene, SoulSkeleton& sk, SoulPose const
     }
 }
 
-static void convertTposeImpl(SoulIK::SoulScene const& srcscene, SoulPose const& tpose) {
+static void convertTposeImpl(SoulIK::SoulScene& srcscene, SoulPose const& tpose) {
 
     SoulIK::SoulSkeletonMesh& srcskm = *srcscene.skmeshes[0];
 
     replacePose(srcscene, srcskm.skeleton, tpose);
-    applyNodeTransform(srcscene.rootNode.get());
+    applyNodeTransform(srcscene);
 
     printf("node treeG");
-    IKRigUtils::debugPrintNodeTree(srcscene.rootNode.get());
+    IKRigUtils::debugPrintNodeTree(srcscene, srcscene.getRootNode());
 
     copyToJointTransform(srcscene);
     applySkin(srcscene);
@@ -264,7 +264,7 @@ void SoulIK::convertToTPose() {
     convertTposeImpl(srcscene, tpose);
 
     // replacePose(srcscene, srcskm.skeleton, tpose);
-    // applyNodeTransform(srcscene.rootNode.get());
+    // applyNodeTransform(srcscene);
     // applyJointTransform(srcscene);
 
     fbxrw.writeSkeletonMesh(outputfile);
@@ -301,8 +301,8 @@ void testMetaFBX() {
     IKRigUtils::debugPrintSkeletonTreeTransform(tscene, tskm);
 
     // // print node tree
-    // IKRigUtils::debugPrintNodePose(ascene.rootNode.get());
-    // IKRigUtils::debugPrintNodePose(tscene.rootNode.get());
+    // IKRigUtils::debugPrintNodePose(ascene);
+    // IKRigUtils::debugPrintNodePose(tscene);
 
 
     // IKRigUtils::debugPrintSkeletonTreeIBM(askm.skeleton);
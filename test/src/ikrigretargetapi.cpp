@@ -315,9 +315,13 @@ bool retargetFBX(std::string const& srcAnimationFile,
     SoulIK::USkeleton srcusk;
     SoulIK::USkeleton tgtusk;
     IKRigUtils::getUSkeletonFromMesh(srcTPoseScene, *srcTPoseScene.skmeshes[0], srcusk, srccoord, workcoord);
-    IKRigUtils::alignUSKWithSkeleton(srcusk, srcskm.skeleton, srcTPoseScene, srcscene);
+    if (!IKRigUtils::alignUSKWithSkeleton(srcusk, srcskm.skeleton, srcTPoseScene, srcscene)) {
+        return false;
+    }
     IKRigUtils::getUSkeletonFromMesh(tgtTPosescene, *tgtTPosescene.skmeshes[0], tgtusk, tgtcoord, workcoord);
-    IKRigUtils::alignUSKWithSkeleton(tgtusk, tgtskm.skeleton, tgtTPosescene, tgtscene); //IKRigUtils::debugPrintUSKNames(tgtusk);    
+    if (!IKRigUtils::alignUSKWithSkeleton(tgtusk, tgtskm.skeleton, tgtTPosescene, tgtscene)) { //IKRigUtils::debugPrintUSKNames(tgtusk);
+        return false;
+    }
     //if (testCase.isTargetNeedHardCodeTPose) {
     //tgtusk.refpose = getMetaTPoseFPose(tgtskm.skeleton, CoordType::RightHandYupZfront, CoordType::RightHandZupYfront);
     //}
@@ -325,9 +329,9 @@ bool retargetFBX(std::string const& srcAnimationFile,
     DEBUG_PRINT_USK("SrcUSK", srcusk, srcskm, srccoord, workcoord);
     DEBUG_PRINT_USK("TgtUSK", tgtusk, tgtskm, tgtcoord, workcoord);
 
+    // clips of the same character pair and config share one plan
     SoulIK::UIKRetargetProcessor ikretarget;
-	std::shared_ptr<UIKRetargeter> InRetargeterAsset = IKRigUtils::createIKRigAsset(config, srcskm.skeleton, tgtskm.skeleton, srcusk, tgtusk);
-    ikretarget.Initialize(&srcusk, &tgtusk, InRetargeterAsset.get(), false); // todo: raw pointer not safe
+    ikretarget.Initialize(IKRigUtils::getRetargetPlan(config, srcskm.skeleton, tgtskm.skeleton, srcusk, tgtusk, ikretarget.Log));
     
     /////////////////////////////////////////////
     // build pose animation form mesh0
@@ -342,48 +346,63 @@ bool retargetFBX(std::string const& srcAnimationFile,
     //         IKRigUtils::getSoulPoseFromMesh(srcscene, srcskm, tempposes[i]);
     //     }
     // }
+    // every buffer of the frame loop is sized here, so the loop itself does not allocate
     tempoutposes.resize(frameCount);
+    for(auto& outpose : tempoutposes) {
+        outpose.transforms.resize(tgtskm.skeleton.joints.size());
+    }
 
     /////////////////////////////////////////////
     // run retarget
     std::unordered_map<FName, float> SpeedValuesFromCurves;
     float DeltaTime = 0;
 
-    std::vector<FTransform> inpose;
-    std::vector<FTransform> inposeLocal;
-    std::vector<FTransform> outposeLocal;
+    // frames go through the retargeter a few at a time, more per batch would push its poses out of cache
+    const int batchSize = 8;
+    const size_t srcJointCount = srcskm.skeleton.joints.size();
+    const size_t tgtJointCount = tgtskm.skeleton.joints.size();
+    std::vector<FTransform> inpose(srcJointCount);
+    std::vector<FTransform> inposeLocal(srcJointCount);
+    std::vector<FTransform> outpose(tgtJointCount);
+    std::vector<FTransform> outposeLocal(tgtJointCount);
+    std::vector<FTransform> inposes(batchSize * srcJointCount);
+    std::vector<FTransform> outposes(batchSize * tgtJointCount);
     std::vector<FTransform> initInPoseLocal = srcusk.refpose;
     std::vector<FTransform> initOutPoseLocal = tgtusk.refpose;
     //std::vector<SoulTransform> initSoulInPoseLocal;
     //std::vector<SoulTransform> initSoulOutPoseLocal;
-    for(int frame = 0; frame < frameCount; frame++) {
+    for(int batchStart = 0; batchStart < frameCount; batchStart += batchSize) {
+        const int batchFrames = std::min(batchSize, frameCount - batchStart);
 
-        DEBUG_PRINT("frame:%d\n", frame);
-        DEBUG_PRINT_IO_SOULPOSE("InSoulPose srccoord", tempposes[frame], srcskm, frame);
+        for(int i = 0; i < batchFrames; i++) {
+            const int frame = batchStart + i;
+            DEBUG_PRINT("frame:%d\n", frame);
+            DEBUG_PRINT_IO_SOULPOSE("InSoulPose srccoord", tempposes[frame], srcskm, frame);
 
-        // input and cast
-        IKRigUtils::SoulPose2FPose(tempposes[frame], inposeLocal);
+            // input and cast
+            IKRigUtils::SoulPose2FPose(tempposes[frame], inposeLocal);
 
-        // coord convert
-        IKRigUtils::LocalFPoseCoordConvert(tsrc2work, srccoord, workcoord, inposeLocal);
-
-        // to global
-        IKRigUtils::FPoseToGlobal(srcskm.skeleton, inposeLocal, inpose);
-        DEBUG_PRINT_IO_FPOSE("inFPose workcoord", srcskm, inposeLocal, inpose, initInPoseLocal, frame);
+            // coord convert and to global
+            IKRigUtils::FPoseToGlobal(srcskm.skeleton, tsrc2work, inposeLocal, inpose);
+            DEBUG_PRINT_IO_FPOSE("inFPose workcoord", srcskm, inposeLocal, inpose, initInPoseLocal, frame);
+            std::copy(inpose.begin(), inpose.end(), inposes.begin() + i * srcJointCount);
+        }
 
         // retarget
-        std::vector<FTransform>& outpose = ikretarget.RunRetargeter(inpose, SpeedValuesFromCurves, DeltaTime);
+        ikretarget.RunRetargeterBatch(inposes.data(), batchFrames, outposes.data(), SpeedValuesFromCurves, DeltaTime);
 
-        // to local
-        IKRigUtils::FPoseToLocal(tgtskm.skeleton, outpose, outposeLocal);
-        DEBUG_PRINT_IO_FPOSE("outFpose workcoord", tgtskm, outposeLocal, outpose, initOutPoseLocal, frame);
+        for(int i = 0; i < batchFrames; i++) {
+            const int frame = batchStart + i;
+            std::copy(outposes.begin() + i * tgtJointCount, outposes.begin() + (i + 1) * tgtJointCount, outpose.begin());
 
-        // coord convert
-        IKRigUtils::LocalFPoseCoordConvert(twork2tgt, workcoord, tgtcoord, outposeLocal);
+            // to local and coord convert
+            IKRigUtils::FPoseToLocal(tgtskm.skeleton, outpose, twork2tgt, outposeLocal);
+            DEBUG_PRINT_IO_FPOSE("outFpose tgtcoord", tgtskm, outposeLocal, outpose, initOutPoseLocal, frame);
 
-        // cast and output
-        IKRigUtils::FPose2SoulPose(outposeLocal, tempoutposes[frame]);
-        DEBUG_PRINT_IO_SOULPOSE("outSoulPose tgtcoord", tempoutposes[frame], tgtskm, frame);
+            // cast and output
+            IKRigUtils::FPose2SoulPose(outposeLocal, tempoutposes[frame]);
+            DEBUG_PRINT_IO_SOULPOSE("outSoulPose tgtcoord", tempoutposes[frame], tgtskm, frame);
+        }
     }
 
     printf("process animation %d keyframes\n", frameCount);